@@ -0,0 +1,333 @@
+// Microbenchmarks for the Board primitives used by move validation and the AI.
+//
+// Run with JSON output to track latency across commits:
+//   ./chess_bench --benchmark_out=bench_results.json --benchmark_out_format=json
+// or build the `bench_json` target.
+
+#include "../include/BatchEvaluator.h"
+#include "../include/Board.h"
+#include "../include/Game.h"
+#include "../include/TranspositionTable.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchPosition {
+    const char* name;
+    const char* fen;
+};
+
+// Representative positions: opening, tactical middlegame, endgame and a mate
+const BenchPosition POSITIONS[] = {
+    {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"},
+    {"middlegame", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+    {"checkmate", "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3"},
+};
+const int NUM_POSITIONS = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+
+// Positions for the batch evaluation benchmarks: random playouts, so every board differs
+const int BATCH_POSITIONS = 4096;
+const int MAX_PLAYOUT_PLIES = 120;
+
+// Morphy's Opera Game in the coordinate notation written by Game::exportPGN
+const char* const OPERA_GAME_PGN =
+    "[Event \"Opera Game\"]\n"
+    "[Site \"Paris\"]\n"
+    "[Result \"1-0\"]\n\n"
+    "1. e2e4 e7e5 2. g1f3 d7d6 3. d2d4 c8g4 4. d4e5 g4f3 5. d1f3 d6e5 "
+    "6. f1c4 g8f6 7. f3b3 d8e7 8. b1c3 c7c6 9. c1g5 b7b5 10. c3b5 c6b5 "
+    "11. c4b5 b8d7 12. e1c1 a8d8 13. d1d7 d8d7 14. h1d1 e7e6 15. b5d7 f6d7 "
+    "16. b3b8 d7b8 17. d1d8\n";
+
+// Game prints every move; keep benchmark output readable
+class CoutSilencer {
+public:
+    CoutSilencer() : saved(std::cout.rdbuf(nullptr)) {}
+    ~CoutSilencer() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+
+private:
+    std::streambuf* saved;
+};
+
+bool whiteToMove(const BenchPosition& position) {
+    return std::string(position.fen).find(" w ") != std::string::npos;
+}
+
+bool loadPosition(benchmark::State& state, Board& board) {
+    const BenchPosition& position = POSITIONS[state.range(0)];
+    state.SetLabel(position.name);
+    if (!board.loadFEN(position.fen)) {
+        state.SkipWithError("invalid FEN");
+        return false;
+    }
+    return true;
+}
+
+std::pair<std::pair<int, int>, std::pair<int, int>> firstLegalMove(const Board& board, bool forWhite) {
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            Piece* piece = board.getPiece(i, j);
+            if (piece && piece->isWhite() == forWhite) {
+                auto moves = board.getLegalMoves(i, j);
+                if (!moves.empty()) {
+                    return {{i, j}, moves[0]};
+                }
+            }
+        }
+    }
+    return {{-1, -1}, {-1, -1}};
+}
+
+void BM_BoardCopy(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    for (auto _ : state) {
+        Board copy = board;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+// Copy-make, as done for every node in the search
+void BM_MovePiece(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    bool white = whiteToMove(POSITIONS[state.range(0)]);
+    auto move = firstLegalMove(board, white);
+    if (move.first.first == -1) {
+        move = firstLegalMove(board, !white); // Side to move is mated
+    }
+    if (move.first.first == -1) {
+        state.SkipWithError("no legal move");
+        return;
+    }
+    for (auto _ : state) {
+        Board copy = board;
+        copy.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+// One query per square of the board
+void BM_IsSquareUnderAttack(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    bool byWhite = !whiteToMove(POSITIONS[state.range(0)]);
+    for (auto _ : state) {
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                benchmark::DoNotOptimize(board.isSquareUnderAttack(i, j, byWhite));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+
+void BM_IsCheck(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    bool white = whiteToMove(POSITIONS[state.range(0)]);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(board.isCheck(white));
+    }
+}
+
+// Legal moves for every piece of the side to move
+void BM_GetLegalMoves(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    bool white = whiteToMove(POSITIONS[state.range(0)]);
+    for (auto _ : state) {
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                Piece* piece = board.getPiece(i, j);
+                if (piece && piece->isWhite() == white) {
+                    benchmark::DoNotOptimize(board.getLegalMoves(i, j));
+                }
+            }
+        }
+    }
+}
+
+void BM_IsCheckmate(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    bool white = whiteToMove(POSITIONS[state.range(0)]);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(board.isCheckmate(white));
+    }
+}
+
+void BM_EvaluatePosition(benchmark::State& state) {
+    Board board;
+    if (!loadPosition(state, board)) return;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(board.evaluatePosition());
+    }
+}
+
+const std::vector<Board>& batchBoards() {
+    static std::vector<Board> boards;
+    if (boards.empty()) {
+        std::mt19937 random(1);
+        Game game;
+        int plies = 0;
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> moves;
+        while (boards.size() < BATCH_POSITIONS) {
+            moves.clear();
+            game.getBoard().generateLegalMoves(game.isWhiteToMove(), moves);
+            if (moves.empty() || plies++ >= MAX_PLAYOUT_PLIES) {
+                game = Game();
+                plies = 0;
+                continue;
+            }
+            const auto& move = moves[random() % moves.size()];
+            game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second);
+            boards.push_back(game.getBoard());
+        }
+    }
+    return boards;
+}
+
+// Scalar reference for the batch evaluator: Board::evaluatePosition on each board in turn
+void BM_EvaluateBoards(benchmark::State& state) {
+    const std::vector<Board>& boards = batchBoards();
+    for (auto _ : state) {
+        for (const Board& board : boards) {
+            benchmark::DoNotOptimize(board.evaluatePosition());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+
+// BatchEvaluator over the same positions; the argument is the SimdLevel
+void BM_BatchEvaluate(benchmark::State& state) {
+    SimdLevel level = static_cast<SimdLevel>(state.range(0));
+    state.SetLabel(simdLevelName(level));
+    if (level > detectSimdLevel()) {
+        state.SkipWithError("not supported by this CPU");
+        return;
+    }
+    PositionBatch batch;
+    for (const Board& board : batchBoards()) {
+        batch.add(board);
+    }
+    BatchEvaluator evaluator;
+    std::vector<int> scores(batch.size());
+    for (auto _ : state) {
+        evaluator.evaluate(batch, scores.data(), level);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+
+void BM_GetFEN(benchmark::State& state) {
+    const BenchPosition& position = POSITIONS[state.range(0)];
+    state.SetLabel(position.name);
+    Game game;
+    if (!game.setFEN(position.fen)) {
+        state.SkipWithError("invalid FEN");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game.getFEN());
+    }
+}
+
+// One-ply search: every legal move is played on a board copy and evaluated
+void BM_GetGreedyMove(benchmark::State& state) {
+    const BenchPosition& position = POSITIONS[state.range(0)];
+    state.SetLabel(position.name);
+    Game game;
+    if (!game.setFEN(position.fen)) {
+        state.SkipWithError("invalid FEN");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game.getGreedyMove());
+    }
+}
+
+// Fixed-depth alpha-beta, dominated by Board copies in copy-make
+void BM_GetMinimaxMove(benchmark::State& state) {
+    const BenchPosition& position = POSITIONS[state.range(0)];
+    state.SetLabel(position.name);
+    Game game;
+    if (!game.setFEN(position.fen)) {
+        state.SkipWithError("invalid FEN");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game.getMinimaxMove(3));
+    }
+}
+
+// Iterative deepening to depth 5 with a transposition table of the second argument's size in MB,
+// cleared before each search. Items are nodes, so items_per_second is the search's nps.
+void BM_SearchTT(benchmark::State& state) {
+    const BenchPosition& position = POSITIONS[state.range(0)];
+    TranspositionTable tt;
+    if (!tt.resize(static_cast<size_t>(state.range(1)))) {
+        state.SkipWithError("could not allocate the table");
+        return;
+    }
+    state.SetLabel(std::string(position.name) + ", " + tt.pageModeName() + " pages");
+    Game game;
+    if (!game.setFEN(position.fen)) {
+        state.SkipWithError("invalid FEN");
+        return;
+    }
+    SearchLimits limits(5);
+    limits.tt = &tt;
+    uint64_t nodes = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        tt.clear();
+        state.ResumeTiming();
+        nodes += game.search(limits).nodes;
+    }
+    state.SetItemsProcessed(nodes);
+}
+
+// Read, parse and replay a 33-ply game through Game::importPGN
+void BM_ImportPGN(benchmark::State& state) {
+    std::string filename = "chess_bench_opera.pgn";
+    {
+        std::ofstream file(filename);
+        file << OPERA_GAME_PGN;
+    }
+    Game game;
+    CoutSilencer silence;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game.importPGN(filename));
+    }
+    std::remove(filename.c_str());
+}
+
+} // namespace
+
+BENCHMARK(BM_BoardCopy)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_MovePiece)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_IsSquareUnderAttack)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_IsCheck)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_GetLegalMoves)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_IsCheckmate)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_EvaluatePosition)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_EvaluateBoards);
+BENCHMARK(BM_BatchEvaluate)->DenseRange(static_cast<int>(SimdLevel::SCALAR), static_cast<int>(SimdLevel::AVX512));
+BENCHMARK(BM_GetFEN)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_GetGreedyMove)->DenseRange(0, NUM_POSITIONS - 1);
+BENCHMARK(BM_GetMinimaxMove)->DenseRange(0, NUM_POSITIONS - 1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SearchTT)->Args({0, 16})->Args({0, 1024})->Args({1, 16})->Args({1, 1024})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImportPGN);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Persistent cache of search results by position (Zobrist key), shared by every search of a
+// process and kept across sessions. Game::search answers from it when it holds a deep enough
+// result (see SearchLimits::cache) and stores every completed search. As the key leaves out the
+// game history, searches whose draw detection could reach it neither store nor take results.
+// The header records the evaluation parameters the scores were searched with (evalParamsHash);
+// when they differ from the current ones, the entries are dropped, on open or on the next use.
+//
+// File layout, native byte order: AnalysisCacheHeader, then an append-only log of
+// AnalysisCacheRecord. A later record for a key supersedes earlier ones. On open the file is
+// memory-mapped and replayed. A torn or corrupt record (bad checksum) ends the log, and the file
+// is rewritten without it. Records are appended whole and flushed to the OS, so a crashed process
+// loses nothing; an OS crash loses at most the records since the last compaction. Compaction
+// writes the live entries to "<file>.tmp", syncs it and renames it over the file. It runs when
+// the log holds twice as many records as there are entries, when entries are evicted, and on
+// close. One process at a time may have a cache file open; its threads share it.
+//
+// Over the size cap, entries are evicted depth-weighted least recently used: each ply of depth
+// counts as CACHE_USES_PER_PLY more recent uses.
+
+const char ANALYSIS_CACHE_MAGIC[8] = {'C', 'H', 'C', 'A', 'C', 'H', 'E', '\0'};
+const uint32_t ANALYSIS_CACHE_VERSION = 2;
+const uint32_t CACHE_USES_PER_PLY = 4096;
+
+struct AnalysisCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t evalHash; // evalParamsHash() of the parameters the scores were searched with
+};
+
+struct AnalysisCacheRecord {
+    uint64_t key;
+    uint64_t nodes;
+    int32_t score;     // White's point of view in centipawns, as SearchResult
+    uint16_t move;     // explorerMoveCode()
+    uint8_t depth;
+    int8_t mateIn;
+    uint32_t lastUsed; // Use clock of the cache when last probed or stored
+    uint32_t checksum; // Of the bytes above
+};
+
+struct AnalysisEntry {
+    std::pair<std::pair<int, int>, std::pair<int, int>> move;
+    int score;
+    int mateIn;
+    int depth;
+    uint64_t nodes;
+};
+
+class AnalysisCache {
+public:
+    AnalysisCache() : log(nullptr), maxEntries(0), logRecords(0), clock(0), compactedClock(0), evalHash(0), failed(false) {}
+    ~AnalysisCache() { close(); }
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+    
+    // Opens the cache file, creating it if it does not exist, holding at most maxEntries.
+    // Prints an error and returns false if it cannot be read or written.
+    bool open(const std::string& filename, size_t maxEntries);
+    bool close(); // Compacts if the log has changed; false if a write failed
+    bool isOpen() const;
+    
+    // Thread-safe. store() keeps an entry only if it is deeper than the one held (or as deep
+    // with more nodes).
+    bool probe(uint64_t key, AnalysisEntry& entry);
+    void store(uint64_t key, const AnalysisEntry& entry);
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex;
+    std::string filename;
+    FILE* log;
+    std::unordered_map<uint64_t, AnalysisCacheRecord> entries;
+    size_t maxEntries;
+    size_t logRecords; // Records in the file, including superseded ones
+    uint32_t clock;
+    uint32_t compactedClock; // clock at the last compaction, which persisted the use times
+    uint64_t evalHash;       // Of the parameters the entries were searched with
+    bool failed;
+    
+    // Called with the mutex held
+    bool append(const AnalysisCacheRecord& record);
+    void checkEvalParams(); // Drops the entries if the evaluation parameters have changed
+    void evict(size_t keep);
+    bool compact();
+};
+
+// Entry capacity for a cache of the given size in megabytes
+size_t analysisCacheEntries(size_t megabytes);
+
+#endif // ANALYSIS_CACHE_H
@@ -0,0 +1,115 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "PGN.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Game archive search: an inverted index from position keys and material signatures to the
+// games and plies where they occur (built by tools/archive.cpp). Each term has a posting list
+// of (game, ply) pairs in game order, compressed as varints of the game id delta and the ply.
+// A position lists every ply it occurred at; a material signature only the ply at which each
+// game first reached it.
+//
+// File layout, native byte order:
+//   ArchiveHeader
+//   PGN file names, NUL-terminated, padded to 8 bytes   fileTableBytes
+//   ArchiveGame[games]                                  by game id
+//   posting lists                                       postingBytes
+//   ArchiveTerm[positionTerms + materialTerms]          sorted by kind, then key
+
+const char ARCHIVE_MAGIC[8] = {'C', 'H', 'A', 'R', 'C', 'H', 'V', '\0'};
+const uint32_t ARCHIVE_VERSION = 1;
+
+enum ArchiveTermKind {
+    ARCHIVE_POSITION = 0, // explorerKey() of the position
+    ARCHIVE_MATERIAL = 1  // materialKey()
+};
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t fileCount;
+    uint64_t games;
+    uint64_t positionTerms;
+    uint64_t materialTerms;
+    uint64_t fileTableBytes;
+    uint64_t postingBytes;
+};
+
+// Where a game is: its PGN file and the offset of its first line
+struct ArchiveGame {
+    uint64_t offset;
+    uint32_t file;
+    uint32_t plies; // Plies replayed up to the end or the first illegal move
+};
+
+struct ArchiveTerm {
+    uint64_t key;
+    uint64_t postings; // Offset of the posting list in the posting section
+    uint32_t kind;     // ArchiveTermKind
+    uint32_t count;    // Postings in the list
+};
+
+struct ArchivePosting {
+    uint32_t game;
+    uint32_t ply; // Plies played before the position: 0 is the game's starting position
+};
+
+// Piece counts other than kings, four bits per piece type and colour
+uint64_t materialKey(const Board& board);
+// "KRPvKR": White's pieces, then Black's, each starting with the king. Case is ignored.
+// Returns false if the text is not a signature.
+bool parseMaterialSignature(const std::string& text, uint64_t& key);
+std::string materialSignature(uint64_t key);
+
+// Read-only view of an archive index file
+class ArchiveIndex {
+public:
+    ArchiveIndex();
+    
+    bool open(const std::string& filename); // Prints an error and returns false on failure
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    const ArchiveHeader& getHeader() const { return *header; }
+    
+    // Decodes up to limit postings of a term (all if limit is 0) in game order and returns how
+    // many the term has in total; 0 if the term is not in the index
+    uint64_t find(ArchiveTermKind kind, uint64_t key, std::vector<ArchivePosting>& postings, size_t limit = 0) const;
+    
+    const ArchiveGame& getGame(uint32_t game) const { return games[game]; }
+    const std::string& getFileName(uint32_t index) const { return fileNames[index]; }
+    bool readGame(uint32_t game, PGNGame& pgn) const; // Reads the game back from its PGN file
+
+private:
+    MappedFile file;
+    const ArchiveHeader* header;
+    std::vector<std::string> fileNames;
+    const ArchiveGame* games;
+    const unsigned char* postingData;
+    const ArchiveTerm* terms;
+};
+
+// Writes an archive index. The game table is written first; terms must then be added in
+// ascending (kind, key) order, and are spooled to "<filename>.terms" until finish().
+class ArchiveIndexWriter {
+public:
+    bool open(const std::string& filename, const std::vector<std::string>& files,
+              const std::vector<ArchiveGame>& games);
+    // Postings in ascending (game, ply) order
+    void add(ArchiveTermKind kind, uint64_t key, const std::vector<ArchivePosting>& postings);
+    bool finish(); // Writes the term table and the header
+
+private:
+    std::string filename;
+    std::ofstream out;
+    std::ofstream termsOut;
+    ArchiveHeader header;
+    std::vector<unsigned char> buffer; // Encoded posting list
+};
+
+#endif // ARCHIVE_H
@@ -0,0 +1,13 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// Non-interactive evaluation for data pipelines (chess --batch). Reads one FEN or EPD record per
+// line from stdin and writes one EPD line per input line to stdout, in input order:
+//   <position> [id "..."; ]bm <SAN>; ce <centipawns>; [dm <moves>; ]acd <depth>; acn <nodes>;
+// Blank and "#" comment lines are copied through; a line that is not a valid position gets
+// c0 "invalid position"; appended.
+// Options: --threads N, and a per-position budget of --nodes N, --movetime ms or --depth N.
+// Throughput is reported on stderr. Returns the process exit code.
+int runBatch(int argc, char* argv[]);
+
+#endif // BATCH_H
@@ -0,0 +1,61 @@
+#ifndef BATCH_EVALUATOR_H
+#define BATCH_EVALUATOR_H
+
+#include "Board.h"
+#include "Evaluation.h"
+#include "TrainingData.h"
+#include <cstdint>
+#include <vector>
+
+// Static evaluation of many independent positions at once, for bulk work such as labelling
+// training data or scoring EPD files. Scores are the same as Board::evaluatePosition.
+
+// Positions in structure-of-arrays layout: one array per (color, piece type) bitboard, so the
+// same bitboard of consecutive positions is contiguous in memory
+class PositionBatch {
+public:
+    PositionBatch() : count(0) {}
+    
+    void clear();
+    void reserve(size_t positions);
+    void add(const Board& board);
+    bool add(const PackedPosition& packed); // False if the record has an invalid piece code
+    size_t size() const { return count; }
+    const Bitboard* pieces(int color, int type) const { return bitboards[color][type].data(); }
+
+private:
+    std::vector<Bitboard> bitboards[COLOR_COUNT][PIECE_TYPE_COUNT];
+    size_t count;
+};
+
+// Instruction sets for BatchEvaluator. AVX2 evaluates 8 positions per step and AVX-512 16.
+enum class SimdLevel { SCALAR, AVX2, AVX512 };
+
+SimdLevel detectSimdLevel(); // Best level this CPU supports
+const char* simdLevelName(SimdLevel level);
+
+// The evaluation is a sum of table lookups by groups of bits of each piece bitboard, the entries
+// holding the material and piece-square values of the pieces in the group. The scalar path looks
+// up whole ranks (bytes). The SIMD paths use in-register permutes as 8- and 16-entry lookups, by
+// 3-bit (AVX2) or 4-bit (AVX-512) groups of the 32-bit bitboard halves of 8 or 16 positions.
+class BatchEvaluator {
+public:
+    explicit BatchEvaluator(const EvalParams& params = getEvalParams());
+    
+    // Writes one score per position (centipawns, White's point of view). The level must be
+    // supported by the CPU; the first overload uses the best one.
+    void evaluate(const PositionBatch& batch, int* scores) const;
+    void evaluate(const PositionBatch& batch, int* scores, SimdLevel level) const;
+
+private:
+    std::vector<int32_t> rankTables;   // [type][rank][byte], rank 0 is rank 8 as seen by White
+    std::vector<int32_t> tripleTables; // [color][type][half][group][bits], as in BatchEvaluator.cpp
+    std::vector<int32_t> nibbleTables;
+    SimdLevel level;
+    
+    void evaluateScalar(const PositionBatch& batch, size_t begin, int* scores) const;
+    size_t evaluateAVX2(const PositionBatch& batch, int* scores) const;   // Returns positions done
+    size_t evaluateAVX512(const PositionBatch& batch, int* scores) const;
+};
+
+#endif // BATCH_EVALUATOR_H
@@ -0,0 +1,53 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+// 64-bit square sets. Square index = row * 8 + column, matching Board's (x, y) layout:
+// bit 0 is a8, bit 7 is h8, bit 56 is a1 and bit 63 is h1.
+typedef uint64_t Bitboard;
+
+enum Color { WHITE, BLACK, COLOR_COUNT };
+enum PieceType { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, PIECE_TYPE_COUNT };
+
+inline int colorIndex(bool isWhite) { return isWhite ? WHITE : BLACK; }
+inline int squareIndex(int x, int y) { return x * 8 + y; }
+inline Bitboard squareBit(int square) { return 1ULL << square; }
+inline Bitboard squareBit(int x, int y) { return 1ULL << squareIndex(x, y); }
+
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lowestSquare(Bitboard b) { return __builtin_ctzll(b); }
+inline int popLowestSquare(Bitboard& b) {
+    int square = __builtin_ctzll(b);
+    b &= b - 1;
+    return square;
+}
+
+// A piece in one byte: PieceType + 1 in bits 0-2 and the Color in bit 3. 0 is an empty square.
+typedef uint8_t PieceCode;
+const PieceCode NO_PIECE = 0;
+const int PIECE_CODE_COUNT = 16;
+
+constexpr PieceCode makePieceCode(int color, int type) { return static_cast<PieceCode>((color << 3) | (type + 1)); }
+constexpr int pieceCodeColor(PieceCode code) { return code >> 3; }
+constexpr int pieceCodeType(PieceCode code) { return (code & 7) - 1; }
+
+// Piece type for a board symbol ('P', 'n', ...), PIECE_TYPE_COUNT if unknown
+PieceType pieceTypeFromSymbol(char symbol);
+PieceCode pieceCodeFromSymbol(char symbol); // NO_PIECE if unknown
+char pieceCodeSymbol(PieceCode code);       // ' ' for NO_PIECE
+
+// Attack sets. Sliders stop at (and include) the first occupied square in each direction.
+Bitboard pawnAttacks(bool isWhite, int square);
+Bitboard knightAttacks(int square);
+Bitboard kingAttacks(int square);
+Bitboard bishopAttacks(int square, Bitboard occupied);
+Bitboard rookAttacks(int square, Bitboard occupied);
+Bitboard queenAttacks(int square, Bitboard occupied);
+
+// Squares strictly between two squares on a shared rank, file or diagonal (0 if not aligned)
+Bitboard betweenSquares(int from, int to);
+// The full rank, file or diagonal through two aligned squares (0 if not aligned)
+Bitboard lineThrough(int from, int to);
+
+#endif // BITBOARD_H
@@ -2,10 +2,11 @@
 #define BOARD_H
 
 #include "../src/Pieces/Piece.h"
+#include "Bitboard.h"
 #include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
-#include <set>
 
 class Board {
 public:
@@ -15,8 +16,10 @@ public:
     Board& operator=(const Board& other); // Assignment operator
     
     void resetBoard();
+    bool loadFEN(const std::string& fen); // Set up pieces, side to move, castling, en passant and halfmove clock
     void printBoard() const;
-    Piece* getPiece(int x, int y) const;
+    Piece* getPiece(int x, int y) const; // Shared Piece object for the square, nullptr if empty
+    PieceCode getPieceCode(int x, int y) const; // NO_PIECE if empty or off the board
     void movePiece(int x1, int y1, int x2, int y2);
     
     // New methods for enhanced functionality
@@ -29,6 +32,7 @@ public:
     std::pair<int, int> findKing(bool isWhiteKing) const;
     bool isSquareUnderAttack(int x, int y, bool byWhite) const;
     std::vector<std::pair<int, int>> getLegalMoves(int x, int y) const;
+    void generateLegalMoves(bool forWhite, std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& moves) const;
     bool isGameOver() const;
     std::string getGameStatus() const;
 
@@ -47,22 +51,82 @@ public:
     
     // AI evaluation
     int evaluatePosition() const;
+    
+    // Position state for hashing and draw rules
+    bool isWhiteToMove() const;
+    int getHalfmoveClock() const; // Plies since the last capture or pawn move
+    int getCastlingRights() const; // CastlingRight bits (see Zobrist.h)
+    uint64_t getZobristKey() const; // Updated incrementally by every move
+    uint64_t computeZobristKey() const; // Recomputed from scratch
+    bool isInsufficientMaterial() const; // Neither side can checkmate
+    
+    // Attack maps (computed once per position on first use)
+    Bitboard getAttackedSquares(bool byWhite) const;
+    Bitboard getAttacksByPieceType(bool byWhite, PieceType type) const;
+    Bitboard getAttackersTo(int x, int y, bool byWhite) const;
+    Bitboard getPieces(bool isWhite, PieceType type) const;
+    Bitboard getOccupancy() const;
+    
+    // Check and pin state for one side (computed once per position on first use)
+    Bitboard getCheckers(bool isWhiteKing) const;   // Enemy pieces giving check
+    Bitboard getPinnedPieces(bool isWhite) const;   // Own pieces pinned to the king
 
 private:
-    std::array<std::array<Piece*, 8>, 8> board;
+    std::array<PieceCode, 64> squares; // Piece on each square index, NO_PIECE if empty
     bool gameOver;
     std::string gameStatus; // "ongoing", "checkmate", "stalemate"
     
-    // Castling tracking
-    std::set<std::pair<int, int>> movedPieces; // Track which pieces have moved
+    // Castling tracking: rights are lost when the king or a rook leaves (or a rook is captured on) its square
+    uint8_t castlingRights;
     
     // En Passant tracking
     std::pair<int, int> enPassantTarget; // Square where en passant is possible (-1, -1) if none
     
+    bool whiteToMove;
+    int halfmoveClock;
+    uint64_t zobristKey;
+    
+    // Piece bitboards, kept in step with squares by putPiece and removePiece
+    Bitboard pieceBitboards[COLOR_COUNT][PIECE_TYPE_COUNT];
+    Bitboard colorOccupancy[COLOR_COUNT];
+    
+    // Attack map cache, invalidated whenever a piece is placed, moved or removed
+    mutable bool attackMapsValid;
+    mutable Bitboard attackedBy[COLOR_COUNT];
+    mutable Bitboard attackedByType[COLOR_COUNT][PIECE_TYPE_COUNT];
+    
+    // Per-side check state: checkers, pinned pieces, squares that block or capture a
+    // single checker, squares attacked through the king, and whether any legal move exists
+    mutable bool checkInfoValid[COLOR_COUNT];
+    mutable Bitboard checkers[COLOR_COUNT];
+    mutable Bitboard pinned[COLOR_COUNT];
+    mutable Bitboard checkMask[COLOR_COUNT];
+    mutable Bitboard kingDanger[COLOR_COUNT];
+    mutable signed char legalMoveState[COLOR_COUNT]; // -1 unknown, 0 none, 1 some
+    
     void setupPieces();
-    bool canMoveWithoutLeavingCheck(int x1, int y1, int x2, int y2, bool isWhiteKing) const;
-    Piece* createPieceCopy(Piece* original) const; // Helper for copy constructor
-    void recordPieceMovement(int x, int y); // Record that a piece has moved
+    void clearPieces(); // Empty the board
+    static Piece* sharedPiece(PieceCode code); // Flyweight Piece object for a piece code
+    void recordPieceMovement(int x, int y); // Drop castling rights tied to a square
+    void putPiece(int square, PieceCode code); // Place on an empty square, updating bitboards and key
+    void removePiece(int square);              // Empty an occupied square, updating bitboards and key
+    void computeAttackMaps() const;
+    Bitboard computeSideAttacks(int color, Bitboard occupied, Bitboard* byType) const;
+    void computeCheckInfo(int color) const;
+    Bitboard legalTargets(int square) const; // Legal destinations of the piece on a square
+    
+    // Move generation specialised per piece type and colour; check info must be current
+    template <PieceType Type, Color Us> Bitboard legalTargets(int square) const;
+    template <PieceType Type, Color Us> void generate(std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& moves) const;
+    template <Color Us> void generateAll(std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& moves) const;
+    template <PieceType Type, Color Us> bool canAnyMove() const;
+    template <Color Us> bool hasAnyLegalMove() const;
+    
+    void invalidateAttackMaps() {
+        attackMapsValid = false;
+        checkInfoValid[WHITE] = checkInfoValid[BLACK] = false;
+        legalMoveState[WHITE] = legalMoveState[BLACK] = -1;
+    }
 };
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// One EPD record: four position fields followed by operations such as
+//   bm Nf3; id "WAC.001"; hmvc 0;
+// A plain FEN line is accepted too; its clocks become hmvc and fmvn.
+struct EPDRecord {
+    std::string position; // Placement, side to move, castling and en passant fields
+    std::vector<std::pair<std::string, std::string>> operations; // Opcode and operand text, in order
+    
+    std::string operation(const std::string& opcode) const; // Operand text, empty if absent
+    std::string toFEN() const; // The position with hmvc/fmvn clocks, or "0 1"
+};
+
+// Returns false for blank lines, comment lines starting with '#', and malformed records
+bool parseEPD(const std::string& line, EPDRecord& record);
+
+// Operand text without surrounding quotes
+std::string unquote(const std::string& operand);
+
+#endif // EPD_H
@@ -0,0 +1,42 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "Game.h"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+
+// Handle to a search running on its own thread. Copies share the search. stop() is cooperative:
+// the search polls the flag every SEARCH_POLL_NODES nodes and then returns its best result so far.
+// When the last handle is destroyed the search is stopped and joined.
+class SearchHandle {
+public:
+    SearchHandle() {}
+    
+    void stop();                      // Returns at once; the result follows shortly
+    bool isFinished() const;          // True once the result is available
+    const SearchResult& wait() const; // Blocks until the search has finished
+    bool valid() const { return shared != nullptr; }
+
+private:
+    friend class Engine;
+    struct Shared {
+        std::atomic<bool> stopRequested{false};
+        std::shared_future<SearchResult> result;
+        ~Shared();
+    };
+    std::shared_ptr<Shared> shared;
+};
+
+class Engine {
+public:
+    // Called on the search thread after every completed depth
+    typedef std::function<void(const SearchResult&)> ProgressCallback;
+    
+    // Searches a copy of the position in the background, within the limits (limits.stop is
+    // replaced by the handle's own flag)
+    static SearchHandle search(const Game& position, SearchLimits limits, ProgressCallback onProgress = nullptr);
+};
+
+#endif // ENGINE_H
@@ -0,0 +1,36 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "Bitboard.h"
+#include <cstdint>
+#include <string>
+
+// Evaluation parameters, in centipawns from White's point of view. The defaults are the classic
+// 1/3/3/5/9 piece values with empty piece-square tables. tools/tune.cpp fits them to labelled
+// positions and writes a parameter file, which the engines load at startup.
+struct EvalParams {
+    int pieceValues[PIECE_TYPE_COUNT];     // The kings cancel out, so the king's is not tuned
+    int pieceSquare[PIECE_TYPE_COUNT][64]; // Bonus by square index from White's side of the board
+    
+    EvalParams(); // Defaults
+};
+
+// Square index from the owner's side of the board: White's as is, Black's mirrored rank-wise
+inline int relativeSquare(int color, int square) { return color == WHITE ? square : square ^ 56; }
+
+// Parameters used by Board::evaluatePosition. setEvalParams must not run during a search.
+const EvalParams& getEvalParams();
+void setEvalParams(const EvalParams& params);
+uint64_t evalParamsHash(const EvalParams& params); // Changes with any parameter; stored with cached scores
+
+// Text format: "value P 100" per piece type, and "pst P" followed by 64 values, rank 8 first as
+// seen by White. Missing entries keep their defaults; '#' starts a comment.
+// Prints an error and returns false if the file cannot be read or is malformed.
+bool loadEvalParams(const std::string& filename, EvalParams& params);
+bool saveEvalParams(const std::string& filename, const EvalParams& params);
+
+// Loads the file named by the CHESS_EVAL_FILE environment variable, or else eval.params in the
+// working directory if there is one. Returns false if a file was found but could not be loaded.
+bool loadStartupEvalParams();
+
+#endif // EVALUATION_H
@@ -0,0 +1,116 @@
+#ifndef EXPLORER_H
+#define EXPLORER_H
+
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Opening explorer: per-move statistics for the positions reached in the first plies of a PGN
+// database (built by tools/explorer.cpp). The index file is memory-mapped and queried in place.
+//
+// File layout, native byte order (an index is read on the architecture that built it):
+//   ExplorerHeader
+//   ExplorerMoveRecord[moveCount]     grouped by position, most played first
+//   ExplorerPosition[positionCount]   sorted by key
+
+const char EXPLORER_MAGIC[8] = {'C', 'H', 'E', 'X', 'P', 'L', 'R', '\0'};
+const uint32_t EXPLORER_VERSION = 1;
+
+struct ExplorerHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t maxPlies;  // Plies of each game that were indexed
+    uint64_t games;
+    uint64_t positionCount;
+    uint64_t moveCount;
+};
+
+struct ExplorerPosition {
+    uint64_t key;       // explorerKey()
+    uint32_t firstMove; // Index of its first ExplorerMoveRecord
+    uint32_t moveCount;
+};
+
+// Results are from the point of view of the side that played the move
+struct ExplorerMoveRecord {
+    uint16_t move;       // explorerMoveCode()
+    uint16_t reserved;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t draws;
+    uint32_t losses;
+    uint32_t ratedGames; // Games with an Elo tag for the side that played the move
+    uint64_t ratingSum;
+    
+    void add(const ExplorerMoveRecord& other); // Sums the counters of the same move
+};
+
+// Zobrist key of the position, except that an en passant square no pawn can capture on is
+// ignored (the board keeps one after every double push, FEN writers often do not)
+uint64_t explorerKey(const Board& board);
+
+// From and to square indexes in 12 bits; pawns always promote to a queen
+uint16_t explorerMoveCode(const std::pair<std::pair<int, int>, std::pair<int, int>>& move);
+std::pair<std::pair<int, int>, std::pair<int, int>> explorerMoveFromCode(uint16_t code);
+
+// One move of a query result
+struct ExplorerMove {
+    std::pair<std::pair<int, int>, std::pair<int, int>> move;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t draws;
+    uint32_t losses;
+    double averageRating; // Of the player making the move, 0 if no game was rated
+    
+    double score() const; // Points per game for the side that played the move
+};
+
+// Read-only view of an index file
+class ExplorerIndex {
+public:
+    ExplorerIndex();
+    ExplorerIndex(const ExplorerIndex&) = delete;
+    ExplorerIndex& operator=(const ExplorerIndex&) = delete;
+    
+    bool open(const std::string& filename); // Prints an error and returns false on failure
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    const ExplorerHeader& getHeader() const { return *header; }
+    
+    // Moves played from the position, most played first; empty if it is not in the index.
+    // The FEN overload returns false if the FEN is invalid.
+    void query(uint64_t key, std::vector<ExplorerMove>& moves) const;
+    void query(const Board& board, std::vector<ExplorerMove>& moves) const;
+    bool query(const std::string& fen, std::vector<ExplorerMove>& moves) const;
+
+private:
+    MappedFile file;
+    const ExplorerHeader* header;
+    const ExplorerMoveRecord* moveRecords;
+    const ExplorerPosition* positions;
+};
+
+// Writes an index file from positions added in ascending key order. The position table is only
+// known at the end, so it is spooled to "<filename>.positions" until finish().
+class ExplorerIndexWriter {
+public:
+    bool open(const std::string& filename, uint32_t maxPlies);
+    // Sorts the moves by games played before writing them
+    void add(uint64_t key, std::vector<ExplorerMoveRecord>& moves);
+    bool finish(uint64_t games); // Writes the header and the position table
+    
+    uint64_t getPositionCount() const { return header.positionCount; }
+    uint64_t getMoveCount() const { return header.moveCount; }
+
+private:
+    std::string filename;
+    std::ofstream out;
+    std::ofstream positionsOut;
+    ExplorerHeader header;
+};
+
+#endif // EXPLORER_H
@@ -2,9 +2,17 @@
 #define GAME_H
 
 #include "Board.h"
+#include "SearchStats.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <string>
 
+// Score for a checkmate in centipawns, well above any material balance
+const int MATE_SCORE = 100000;
+
 enum class AIDifficulty {
     RANDOM,
     GREEDY,
@@ -22,6 +30,53 @@ struct Move {
     }
 };
 
+class AnalysisCache;
+class TranspositionTable;
+
+// Budget for Game::search. Zero means unlimited; with no limit at all the search stops at depth 3.
+// stop, if set, is polled with the clock every SEARCH_POLL_NODES nodes; setting it ends the search
+// as if a limit had been reached. multiPV is the number of best moves scored exactly (MultiPV).
+// cache, if set, answers a single-PV search from a stored result at least as deep (or with as
+// many nodes, for a node limit) as the search would reach; otherwise the stored best move is
+// searched first. Completed searches are stored in it. tt, if set, is the transposition table the
+// search probes and fills at every interior node; concurrent searches may share one.
+struct SearchLimits {
+    int depth;
+    uint64_t nodes;
+    int movetimeMs;
+    const std::atomic<bool>* stop;
+    int multiPV;
+    AnalysisCache* cache;
+    TranspositionTable* tt;
+    bool infinite; // Runs until stopped: depth is only a cap, and neither a mate nor the cache ends it early
+    SearchLimits(int depth = 0, uint64_t nodes = 0, int movetimeMs = 0)
+        : depth(depth), nodes(nodes), movetimeMs(movetimeMs), stop(nullptr), multiPV(1), cache(nullptr), tt(nullptr),
+          infinite(false) {}
+};
+
+// Nodes between checks of the clock and the stop flag, which bounds the stop latency
+const uint64_t SEARCH_POLL_NODES = 1024;
+
+// One ranked root move of a search
+struct SearchLine {
+    std::pair<std::pair<int, int>, std::pair<int, int>> move;
+    int score;  // As SearchResult::score
+    int mateIn; // As SearchResult::mateIn
+    int depth;
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> pv; // Starts with move
+};
+
+struct SearchResult {
+    std::pair<std::pair<int, int>, std::pair<int, int>> bestMove; // {{-1, -1}, {-1, -1}} if there is no legal move
+    int score;      // White's point of view in centipawns; beyond +/-MATE_SCORE for a forced mate
+    int mateIn;     // Moves to mate, negative when Black mates, 0 if no mate was found
+    int depth;      // Last fully searched depth
+    uint64_t nodes;
+    double seconds;
+    SearchStats stats;
+    std::vector<SearchLine> lines; // Best first, up to SearchLimits::multiPV; lines[0] is bestMove
+};
+
 class Game {
 public:
     Game();
@@ -38,20 +93,75 @@ public:
     std::string getFEN() const;
     bool setFEN(const std::string& fen);
     void displaySaveLoadHelp() const;
+    
+    // Engine interface for the command-line tools (no console output)
+    bool applyMove(int x1, int y1, int x2, int y2); // Validate and play a move for the side to move
+    const Board& getBoard() const;
+    bool isWhiteToMove() const;
+    std::string getDrawReason() const; // Empty unless drawn by repetition, 50-move rule or material
+    const SearchStats& getLastSearchStats() const; // Statistics of the AI's last minimax search
+    
+    // Takeback and navigation along the game's line: the moves played plus those taken back, which
+    // are kept until a different move is played. Quiet; false if there is no such ply.
+    bool undoMove();
+    bool redoMove();
+    bool gotoPly(int ply); // Plies since the start position
+    int getPly() const;
+    int getLastPly() const; // Of the line, including the moves taken back
+    
+    // AI move selection
+    std::pair<std::pair<int, int>, std::pair<int, int>> getRandomMove() const;
+    std::pair<std::pair<int, int>, std::pair<int, int>> getGreedyMove() const;
+    std::pair<std::pair<int, int>, std::pair<int, int>> getMinimaxMove(int depth) const;
+    // Iterative deepening within the limits; onIteration sees the result after each completed depth
+    SearchResult search(const SearchLimits& limits,
+                        const std::function<void(const SearchResult&)>& onIteration = nullptr) const;
 
 private:
     Board board;
     bool currentPlayer; // true = white, false = black
     int moveCount;
     std::vector<Move> moveHistory;
+    std::string startFEN; // Position the move history starts from
+    std::vector<uint64_t> positionHistory; // Zobrist keys of every position since startFEN
+    // Moves taken back and the keys of the positions after them, the next one last.
+    // checkpoints[i] is the board after ply i * HISTORY_CHECKPOINT_PLIES of the line, so any ply
+    // is rebuilt by replaying fewer than HISTORY_CHECKPOINT_PLIES moves.
+    std::vector<Move> redoMoves;
+    std::vector<uint64_t> redoKeys;
+    std::vector<Board> checkpoints;
+    
+    // Per-search node count, limits and the key stack of the game plus the current line
+    struct SearchState {
+        std::vector<uint64_t> keyStack;
+        uint64_t nodes;
+        uint64_t nodeLimit;
+        bool hasDeadline;
+        std::chrono::steady_clock::time_point deadline;
+        const std::atomic<bool>* stopFlag;
+        bool stopped;
+        TranspositionTable* tt;
+        SearchStats stats;
+        
+        // Triangular principal variation table: row p holds the best line found from ply p
+        int rootPly; // keyStack size at the root
+        int pvStride;
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> pvMoves;
+        std::vector<int> pvLength;
+        void initPV(int rootKeys, int maxDepth);
+        void updatePV(int ply, const std::pair<std::pair<int, int>, std::pair<int, int>>& move);
+    };
     
     // AI variables
     bool aiEnabled;
     AIDifficulty aiDifficulty;
     bool aiPlaysAsWhite;
+    SearchStats lastSearchStats;
     
     // Helper methods
     bool makeMove(int x1, int y1, int x2, int y2);
+    void recordMove(int x1, int y1, int x2, int y2); // Plays a validated move into the history
+    void resetHistory(); // The current position becomes the start of an empty history
     bool isValidMove(int x1, int y1, int x2, int y2) const;
     void displayMoveHistory() const;
     void displayGameStatus() const;
@@ -59,7 +169,12 @@ private:
     bool handleSpecialCommands(const std::string& input);
     void makeAIMove();
     int evaluatePosition() const;
-    int minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer) const;
+    std::pair<std::pair<int, int>, std::pair<int, int>> minimaxMove(int depth, SearchStats& stats) const;
+    int minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer, SearchState& state) const;
+    int searchRoot(std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& legalMoves, int depth,
+                   SearchState& state, std::vector<SearchLine>& lines, int multiPV) const;
+    bool searchLimitReached(SearchState& state) const;
+    bool isDrawnPosition(const Board& node, const std::vector<uint64_t>& keyStack) const;
     std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> getAllLegalMoves(bool forWhite) const;
     void displayAISettings() const;
     
@@ -72,9 +187,6 @@ private:
     void announceGameEnd() const;
     
     // AI helper methods
-    std::pair<std::pair<int, int>, std::pair<int, int>> getRandomMove() const;
-    std::pair<std::pair<int, int>, std::pair<int, int>> getGreedyMove() const;
-    std::pair<std::pair<int, int>, std::pair<int, int>> getMinimaxMove(int depth) const;
     int getPieceValue(char piece) const;
     
     // Move parsing methods
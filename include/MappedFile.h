@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file, memory-mapped where the platform allows it (read into memory
+// otherwise). Used by the index files, which are queried in place.
+class MappedFile {
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    // Prints an error and returns false if the file cannot be opened or is empty.
+    // randomAccess hints that reads jump around the file, so read-ahead would be wasted.
+    bool open(const std::string& filename, bool randomAccess);
+    void close();
+    bool isOpen() const { return bytes != nullptr; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes;
+    size_t length;
+};
+
+#endif // MAPPED_FILE_H
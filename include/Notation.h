@@ -0,0 +1,28 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <string>
+#include <utility>
+
+class Board;
+
+// Coordinate notation shared by the command-line tools.
+// Squares use the board's (row, column) layout: row 0 is rank 8, column 0 is file a.
+
+std::string squareToNotation(int x, int y);                       // (6, 4) -> "e2"
+std::pair<int, int> notationToSquare(const std::string& notation); // "e2" -> (6, 4), (-1, -1) if invalid
+std::string moveToNotation(int x1, int y1, int x2, int y2);       // -> "e2e4"
+
+// Parses "e2e4" (an optional promotion suffix such as "e7e8q" is accepted and ignored,
+// pawns always promote to a queen). Returns {{-1, -1}, {-1, -1}} if invalid.
+std::pair<std::pair<int, int>, std::pair<int, int>> parseCoordinateMove(const std::string& move);
+
+// Parses a legal move for the side to move in standard algebraic notation ("Nf3", "exd5",
+// "Rae1", "O-O", "e8=Q+", annotations such as "!?" allowed) or coordinate notation ("e2e4").
+// Returns {{-1, -1}, {-1, -1}} if the move is malformed, ambiguous or illegal.
+std::pair<std::pair<int, int>, std::pair<int, int>> parseMove(const Board& board, const std::string& move);
+
+// Standard algebraic notation for a legal move of the side to move ("Nbd7", "exd6", "O-O", "e8=Q#")
+std::string moveToSAN(const Board& board, const std::pair<std::pair<int, int>, std::pair<int, int>>& move);
+
+#endif
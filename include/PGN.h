@@ -0,0 +1,51 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One game from a PGN database
+struct PGNGame {
+    std::vector<std::pair<std::string, std::string>> tags; // In file order
+    std::vector<std::string> moves; // Move tokens without numbers, comments, NAGs or variations
+    std::string result;             // "1-0", "0-1", "1/2-1/2" or "*"
+    
+    std::string tag(const std::string& name) const; // Empty if absent
+};
+
+// Reads the next game from a stream of concatenated PGN games. Returns false at end of input.
+bool readPGNGame(std::istream& in, PGNGame& game);
+
+// Writes the tag section followed by a blank line
+void writePGNTags(std::ostream& out, const PGNGame& game);
+
+// A byte range of a PGN file, for reading a database in parallel. It holds the games whose first
+// line starts inside the range; games are found at lines starting with the file's first tag.
+struct PGNShard {
+    std::string file;
+    uint64_t begin;
+    uint64_t end;
+    std::string startTag; // Usually "[Event "; empty if the file does not start with a tag
+};
+
+// Appends shards of about shardBytes covering the file; a file without a leading tag is one
+// shard. Prints an error and returns false if the file cannot be opened.
+bool splitPGNFile(const std::string& file, uint64_t shardBytes, std::vector<PGNShard>& shards);
+
+// Reads the games of one shard, in file order
+class PGNShardReader {
+public:
+    bool open(const PGNShard& shard); // False if the file cannot be opened or the shard holds no game
+    bool next(PGNGame& game, uint64_t& offset); // offset: where the game starts in the file
+
+private:
+    std::ifstream in;
+    uint64_t end;
+};
+
+#endif // PGN_H
@@ -0,0 +1,48 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Counters collected by Game::search. Each search keeps its own copy in its search state, so
+// concurrent searches never share counters; merge() combines the results afterwards.
+// Building with CHESS_NO_SEARCH_STATS compiles the counting out of the search; nodes and the
+// per-depth times are still recorded, as the search limits need them anyway.
+#ifdef CHESS_NO_SEARCH_STATS
+#define SEARCH_STAT(statement) ((void)0)
+#else
+#define SEARCH_STAT(statement) (statement)
+#endif
+
+struct DepthStats {
+    int depth;
+    uint64_t nodes; // Nodes searched by this iteration alone
+    double seconds; // Time spent in this iteration alone
+};
+
+struct SearchStats {
+    uint64_t nodes = 0;
+    uint64_t leafNodes = 0;        // Positions evaluated at the horizon (there is no quiescence search)
+    uint64_t cutoffs = 0;          // Beta cutoffs in interior nodes
+    uint64_t firstMoveCutoffs = 0; // Of which on the first move searched
+    uint64_t ttProbes = 0;         // Transposition table lookups, one per interior node
+    uint64_t ttHits = 0;           // Lookups that found the position
+    uint64_t ttCutoffs = 0;        // Hits whose stored bound ended the node
+    uint64_t ttStores = 0;         // Results written, one per completed interior node
+    uint64_t ttCollisions = 0;     // Stores that replaced an entry of another position
+    double seconds = 0;
+    std::vector<DepthStats> depths; // One entry per completed iteration
+    
+    double nodesPerSecond() const;
+    double branchingFactor() const;   // Nodes of the last iteration over the one before, 0 if unknown
+    double firstMoveCutoffRate() const; // 0 when there were no cutoffs
+    double ttHitRate() const;           // 0 when there were no probes
+    
+    void merge(const SearchStats& other); // Adds counters; per-depth entries are summed by depth
+    void print(std::ostream& out) const;  // Human-readable report
+    std::string toJSON() const;           // Single line, no trailing newline
+};
+
+#endif // SEARCH_STATS_H
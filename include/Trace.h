@@ -0,0 +1,62 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+// Scoped timing probes for the hot paths, exported as Chrome Trace Event JSON (open the file in
+// Perfetto or chrome://tracing). The probes exist only in builds configured with CHESS_TRACE;
+// otherwise TRACE_SCOPE expands to nothing. Even when compiled in, a probe records only between
+// traceStart and traceStop, into a fixed-size ring buffer owned by its thread, so a long trace
+// keeps the most recent events of every thread.
+
+bool traceCompiledIn();
+bool traceStart(const std::string& filename); // False if tracing is compiled out or already on
+// Writes the trace file; call it while no search is running. False if not tracing or on error.
+bool traceStop();
+
+#ifdef CHESS_TRACE
+
+#include <atomic>
+#include <chrono>
+
+extern std::atomic<bool> traceEnabled;
+
+void traceRecord(const char* name, int arg, uint64_t startNs, uint64_t endNs);
+
+inline uint64_t traceNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Records the time between construction and destruction; arg (e.g. a search depth) is shown
+// with the event unless it is negative
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, int arg = -1)
+        : name(traceEnabled.load(std::memory_order_relaxed) ? name : nullptr),
+          arg(arg),
+          start(this->name ? traceNow() : 0) {}
+    ~TraceScope() {
+        if (name) traceRecord(name, arg, start, traceNow());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    int arg;
+    uint64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+
+#else
+
+#define TRACE_SCOPE(...) ((void)0)
+
+#endif // CHESS_TRACE
+
+#endif // TRACE_H
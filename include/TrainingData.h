@@ -0,0 +1,74 @@
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+
+#include "Board.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Labelled positions for evaluation tuning (written by tools/selfplay.cpp). A file is a plain
+// array of PackedPosition records, native byte order, so files can be concatenated or split.
+
+// A position with its search score and game result in 32 bytes
+struct PackedPosition {
+    uint64_t occupancy;    // Bit per occupied square, Board square index order (bit 0 is a8)
+    uint8_t pieces[16];    // PieceCode of each occupied square in bit order, low nibble first
+    int16_t score;         // Search score in centipawns, White's point of view
+    int8_t result;         // 1 White won, 0 draw, -1 Black won
+    uint8_t state;         // Bit 0: Black to move; bits 1-4: CastlingRight bits
+    uint8_t enPassantFile; // File of the en passant target square plus one, 0 if none
+    uint8_t halfmoveClock;
+    uint16_t ply;          // Plies since the start of the game
+};
+
+// Returns false if the board has more than 32 pieces
+bool packPosition(const Board& board, int score, int result, int ply, PackedPosition& packed);
+std::string packedPositionToFEN(const PackedPosition& packed);
+bool unpackPosition(const PackedPosition& packed, Board& board);
+
+// Appends records to a file through a buffer. write() may be called from several threads; each
+// call's records stay together. The buffer is written when full, and written and fsynced by the
+// first write() after syncSeconds have passed since the last sync, and by close().
+class TrainingDataWriter {
+public:
+    TrainingDataWriter() : file(nullptr), syncSeconds(0), records(0), failed(false) {}
+    ~TrainingDataWriter() { close(); }
+    TrainingDataWriter(const TrainingDataWriter&) = delete;
+    TrainingDataWriter& operator=(const TrainingDataWriter&) = delete;
+    
+    bool open(const std::string& filename, double syncSeconds); // Prints an error on failure
+    bool write(const std::vector<PackedPosition>& positions);
+    bool close(); // Flushes and syncs; false if any write failed
+    uint64_t getRecordsWritten() const { return records; }
+
+private:
+    std::mutex mutex;
+    FILE* file;
+    std::vector<PackedPosition> buffer;
+    double syncSeconds;
+    std::chrono::steady_clock::time_point lastSync;
+    uint64_t records;
+    bool failed;
+    
+    bool flush(bool sync); // Called with the mutex held
+};
+
+// Reads a record file sequentially through a buffer
+class TrainingDataReader {
+public:
+    TrainingDataReader() : position(0) {}
+    
+    bool open(const std::string& filename); // Prints an error on failure
+    bool read(PackedPosition& packed);      // False at the end of the file
+
+private:
+    std::ifstream in;
+    std::vector<PackedPosition> buffer;
+    size_t position;
+};
+
+#endif // TRAINING_DATA_H
@@ -0,0 +1,86 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Table of search results by position (Zobrist key), kept in memory within and between the
+// searches of a process. Game::search probes it at every interior node (see SearchLimits::tt) for
+// a bound that ends the node or a move to search first, and stores the result of every node.
+//
+// A key maps to one bucket of TT_BUCKET_ENTRIES entries filling a 64-byte cache line, so a probe
+// is a single memory access; the search prefetches it as soon as the move leading to the position
+// is made. Entries are written without locks as (key ^ data, data), so concurrent searches may
+// share a table: an entry torn by racing stores fails the key check and reads as a miss.
+//
+// A table of gigabytes misses the TLB on nearly every probe with 4 KB pages, so the memory comes
+// from huge pages where the OS provides them: MAP_HUGETLB, else madvise(MADV_HUGEPAGE) (Linux).
+// clear() zeroes the table from several threads, each pinned to the CPUs of one NUMA node in
+// turn, so that first-touch placement spreads the pages over the nodes the searches run on.
+
+const int TT_BUCKET_ENTRIES = 4;
+
+enum class TTBound : uint8_t { NONE, UPPER, LOWER, EXACT };
+
+struct TTEntry {
+    std::pair<std::pair<int, int>, std::pair<int, int>> move; // {{-1, -1}, {-1, -1}} if none
+    int score; // White's point of view; mate scores count plies from this position (see Game.cpp)
+    int depth;
+    TTBound bound;
+};
+
+class TranspositionTable {
+public:
+    TranspositionTable() : buckets(nullptr), bucketMask(0), bytes(0), pageMode(PageMode::NORMAL), generation(0) {}
+    ~TranspositionTable() { release(); }
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+    
+    // Allocates the largest power of two number of buckets that fits in the given size and
+    // clears it with the given number of threads. Prints an error and returns false if the
+    // memory cannot be allocated, leaving the table empty.
+    bool resize(size_t megabytes, int threads = 1);
+    void clear(int threads = 1);
+    bool empty() const { return buckets == nullptr; }
+    size_t sizeMB() const { return bytes >> 20; }
+    const char* pageModeName() const; // "hugetlb", "transparent" or "normal"
+    
+    void newSearch(); // Ages the entries of earlier searches, which are replaced first
+    
+    // Thread-safe
+    bool probe(uint64_t key, TTEntry& entry) const;
+    bool store(uint64_t key, const TTEntry& entry); // True if it replaced an entry of another position
+    int hashfull() const; // Permille of a sample of entries written by the current search
+    
+    void prefetch(uint64_t key) const {
+#ifdef __GNUC__
+        if (buckets) __builtin_prefetch(&buckets[key & bucketMask]);
+#else
+        (void)key;
+#endif
+    }
+
+private:
+    enum class PageMode { NORMAL, TRANSPARENT, HUGETLB };
+    
+    struct Slot {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;  // Packed TTEntry and generation; 0 if empty
+    };
+    struct alignas(64) Bucket {
+        Slot slots[TT_BUCKET_ENTRIES];
+    };
+    static_assert(sizeof(Bucket) == 64, "A bucket fills one cache line");
+    
+    Bucket* buckets;
+    size_t bucketMask;
+    size_t bytes;
+    PageMode pageMode;
+    std::atomic<unsigned> generation;
+    
+    void release();
+};
+
+#endif // TRANSPOSITION_TABLE_H
@@ -0,0 +1,22 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// Random keys for hashing positions. Generated from a fixed seed, so keys are identical
+// across runs and builds (they may be stored in files).
+
+// Castling rights bits, as used by Board and the castling keys
+enum CastlingRight {
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8
+};
+
+uint64_t zobristPieceKey(int color, int type, int square);
+uint64_t zobristCastlingKey(int castlingRights);
+uint64_t zobristEnPassantKey(int file);
+uint64_t zobristSideKey(); // Included when Black is to move
+
+#endif // ZOBRIST_H
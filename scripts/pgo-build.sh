@@ -0,0 +1,18 @@
+#!/bin/sh
+# Two-stage profile-guided build: instrument, train on the bench workload, rebuild.
+# Both stages share build/pgo so the profile matches the object files.
+set -e
+cd "$(dirname "$0")/.."
+
+rm -rf build/pgo-profile
+cmake --preset pgo-generate
+cmake --build --preset pgo-generate -j
+cmake --build --preset pgo-generate --target pgo_train
+
+if [ -n "$(ls build/pgo-profile/*.profraw 2>/dev/null)" ]; then
+    llvm-profdata merge -o build/pgo-profile/chess.profdata build/pgo-profile/*.profraw
+fi
+
+cmake --preset pgo-use
+cmake --build --preset pgo-use -j
+echo "PGO build ready in build/pgo"
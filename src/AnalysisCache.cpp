@@ -0,0 +1,265 @@
+#include "../include/AnalysisCache.h"
+#include "../include/Evaluation.h"
+#include "../include/Explorer.h"
+#include "../include/MappedFile.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(AnalysisCacheHeader) == 24, "AnalysisCacheHeader is part of the file format");
+static_assert(sizeof(AnalysisCacheRecord) == 32, "AnalysisCacheRecord is part of the file format");
+
+namespace {
+
+// Superseded records tolerated before the log is compacted
+const size_t COMPACT_MIN_RECORDS = 4096;
+
+// FNV-1a over the record up to its checksum
+uint32_t recordChecksum(const AnalysisCacheRecord& record) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(AnalysisCacheRecord, checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool writeHeader(FILE* file, uint64_t evalHash) {
+    AnalysisCacheHeader header;
+    std::memcpy(header.magic, ANALYSIS_CACHE_MAGIC, sizeof(ANALYSIS_CACHE_MAGIC));
+    header.version = ANALYSIS_CACHE_VERSION;
+    header.recordSize = sizeof(AnalysisCacheRecord);
+    header.evalHash = evalHash;
+    return std::fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+} // namespace
+
+size_t analysisCacheEntries(size_t megabytes) {
+    return megabytes * 1024 * 1024 / sizeof(AnalysisCacheRecord);
+}
+
+bool AnalysisCache::open(const std::string& filename, size_t maxEntries) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    this->filename = filename;
+    this->maxEntries = std::max<size_t>(1, maxEntries);
+    entries.clear();
+    logRecords = 0;
+    clock = 0;
+    evalHash = evalParamsHash(getEvalParams());
+    failed = false;
+    
+    // Replay the log; anything after the first bad record is dropped by rewriting the file. An
+    // empty file was created by a process that stopped before writing the header.
+    std::ifstream existing(filename, std::ios::binary | std::ios::ate);
+    bool rewrite = !existing.is_open() || existing.tellg() == 0;
+    existing.close();
+    if (!rewrite) {
+        MappedFile file;
+        if (!file.open(filename, false)) {
+            return false;
+        }
+        const AnalysisCacheHeader* header = reinterpret_cast<const AnalysisCacheHeader*>(file.data());
+        if (file.size() < offsetof(AnalysisCacheHeader, evalHash) ||
+            std::memcmp(header->magic, ANALYSIS_CACHE_MAGIC, sizeof(ANALYSIS_CACHE_MAGIC)) != 0) {
+            std::cerr << "Error: " << filename << " is not an analysis cache.\n";
+            return false;
+        }
+        
+        // An older format, or scores of other evaluation parameters, start the cache afresh
+        bool current = file.size() >= sizeof(AnalysisCacheHeader) && header->version == ANALYSIS_CACHE_VERSION &&
+                       header->recordSize == sizeof(AnalysisCacheRecord) && header->evalHash == evalHash;
+        size_t bytes = current ? file.size() - sizeof(AnalysisCacheHeader) : 0;
+        rewrite = !current || bytes % sizeof(AnalysisCacheRecord) != 0;
+        for (size_t i = 0; i < bytes / sizeof(AnalysisCacheRecord); ++i) {
+            AnalysisCacheRecord record;
+            std::memcpy(&record, file.data() + sizeof(AnalysisCacheHeader) + i * sizeof(record), sizeof(record));
+            if (record.checksum != recordChecksum(record)) {
+                rewrite = true;
+                break;
+            }
+            entries[record.key] = record;
+            clock = std::max(clock, record.lastUsed);
+            logRecords++;
+        }
+    }
+    compactedClock = clock;
+    
+    if (entries.size() > this->maxEntries) {
+        evict(this->maxEntries);
+        rewrite = true;
+    }
+    if (rewrite && !compact()) {
+        if (log) std::fclose(log);
+        log = nullptr;
+        return false;
+    }
+    if (!log) {
+        log = std::fopen(filename.c_str(), "ab");
+    }
+    if (!log) {
+        std::cerr << "Error: Could not open file " << filename << " for writing.\n";
+        return false;
+    }
+    return true;
+}
+
+bool AnalysisCache::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!log) {
+        return !failed;
+    }
+    if (logRecords != entries.size() || clock != compactedClock) {
+        compact();
+    }
+    if (log && std::fclose(log) != 0) {
+        failed = true;
+    }
+    log = nullptr;
+    return !failed;
+}
+
+bool AnalysisCache::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return log != nullptr;
+}
+
+bool AnalysisCache::probe(uint64_t key, AnalysisEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    checkEvalParams();
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return false;
+    }
+    AnalysisCacheRecord& record = found->second;
+    record.lastUsed = ++clock;
+    entry.move = explorerMoveFromCode(record.move);
+    entry.score = record.score;
+    entry.mateIn = record.mateIn;
+    entry.depth = record.depth;
+    entry.nodes = record.nodes;
+    return true;
+}
+
+void AnalysisCache::store(uint64_t key, const AnalysisEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!log) {
+        return;
+    }
+    checkEvalParams();
+    int depth = std::min(entry.depth, 255);
+    auto found = entries.find(key);
+    if (found != entries.end() && !(depth > found->second.depth ||
+                                    (depth == found->second.depth && entry.nodes > found->second.nodes))) {
+        found->second.lastUsed = ++clock;
+        return;
+    }
+    
+    AnalysisCacheRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.key = key;
+    record.nodes = entry.nodes;
+    record.score = entry.score;
+    record.move = explorerMoveCode(entry.move);
+    record.depth = static_cast<uint8_t>(depth);
+    record.mateIn = static_cast<int8_t>(std::max(-127, std::min(127, entry.mateIn)));
+    record.lastUsed = ++clock;
+    record.checksum = recordChecksum(record);
+    entries[key] = record;
+    append(record);
+    
+    // Evicting an eighth at a time keeps a full cache from compacting on every store
+    if (entries.size() > maxEntries) {
+        evict(maxEntries - maxEntries / 8);
+        compact();
+    } else if (logRecords > 2 * entries.size() + COMPACT_MIN_RECORDS) {
+        compact();
+    }
+}
+
+size_t AnalysisCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+bool AnalysisCache::append(const AnalysisCacheRecord& record) {
+    if (std::fwrite(&record, sizeof(record), 1, log) != 1 || std::fflush(log) != 0) {
+        failed = true;
+        return false;
+    }
+    logRecords++;
+    return true;
+}
+
+void AnalysisCache::checkEvalParams() {
+    uint64_t hash = evalParamsHash(getEvalParams());
+    if (!log || hash == evalHash) {
+        return;
+    }
+    evalHash = hash;
+    entries.clear();
+    compact();
+}
+
+void AnalysisCache::evict(size_t keep) {
+    if (entries.size() <= keep) {
+        return;
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> priorities; // (priority, key), lowest evicted first
+    priorities.reserve(entries.size());
+    for (const auto& entry : entries) {
+        const AnalysisCacheRecord& record = entry.second;
+        priorities.emplace_back(record.lastUsed + static_cast<uint64_t>(record.depth) * CACHE_USES_PER_PLY, entry.first);
+    }
+    size_t evicted = entries.size() - keep;
+    std::nth_element(priorities.begin(), priorities.begin() + evicted, priorities.end());
+    for (size_t i = 0; i < evicted; ++i) {
+        entries.erase(priorities[i].second);
+    }
+}
+
+bool AnalysisCache::compact() {
+    std::string temp = filename + ".tmp";
+    FILE* out = std::fopen(temp.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Error: Could not open file " << temp << " for writing.\n";
+        failed = true;
+        return false;
+    }
+    bool ok = writeHeader(out, evalHash);
+    for (auto& entry : entries) {
+        entry.second.checksum = recordChecksum(entry.second);
+        ok = ok && std::fwrite(&entry.second, sizeof(entry.second), 1, out) == 1;
+    }
+    ok = ok && std::fflush(out) == 0;
+#ifndef _WIN32
+    ok = ok && fsync(fileno(out)) == 0;
+#endif
+    ok = std::fclose(out) == 0 && ok;
+    
+    if (log) {
+        std::fclose(log);
+        log = nullptr;
+    }
+#ifdef _WIN32
+    if (ok) std::remove(filename.c_str()); // rename does not replace files on Windows
+#endif
+    if (!ok || std::rename(temp.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Error: Could not write " << filename << ".\n";
+        std::remove(temp.c_str());
+        failed = true;
+        log = std::fopen(filename.c_str(), "ab");
+        return false;
+    }
+    logRecords = entries.size();
+    compactedClock = clock;
+    log = std::fopen(filename.c_str(), "ab");
+    return log != nullptr;
+}
@@ -0,0 +1,258 @@
+#include "../include/Archive.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(ArchiveHeader) == 56, "ArchiveHeader is part of the file format");
+static_assert(sizeof(ArchiveGame) == 16, "ArchiveGame is part of the file format");
+static_assert(sizeof(ArchiveTerm) == 24, "ArchiveTerm is part of the file format");
+
+namespace {
+
+// Piece types of a material key, in signature order
+const PieceType MATERIAL_TYPES[] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+const char MATERIAL_SYMBOLS[] = "QRBNP";
+const int MATERIAL_TYPE_COUNT = 5;
+
+int materialShift(int color, int index) {
+    return color * MATERIAL_TYPE_COUNT * 4 + index * 4;
+}
+
+void writeVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+uint32_t readVarint(const unsigned char*& in) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        unsigned char byte = *in++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+bool termLess(const ArchiveTerm& term, const std::pair<uint32_t, uint64_t>& value) {
+    return term.kind != value.first ? term.kind < value.first : term.key < value.second;
+}
+
+} // namespace
+
+uint64_t materialKey(const Board& board) {
+    uint64_t key = 0;
+    for (int color = WHITE; color <= BLACK; ++color) {
+        for (int i = 0; i < MATERIAL_TYPE_COUNT; ++i) {
+            uint64_t count = static_cast<uint64_t>(popCount(board.getPieces(color == WHITE, MATERIAL_TYPES[i])));
+            key |= std::min<uint64_t>(count, 15) << materialShift(color, i);
+        }
+    }
+    return key;
+}
+
+bool parseMaterialSignature(const std::string& text, uint64_t& key) {
+    std::string signature;
+    for (char c : text) {
+        signature += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    size_t separator = signature.find('V');
+    if (separator == std::string::npos) {
+        return false;
+    }
+    
+    key = 0;
+    std::string sides[2] = {signature.substr(0, separator), signature.substr(separator + 1)};
+    for (int color = WHITE; color <= BLACK; ++color) {
+        const std::string& side = sides[color];
+        if (side.empty() || side[0] != 'K') {
+            return false;
+        }
+        for (size_t i = 1; i < side.length(); ++i) {
+            const char* symbol = std::strchr(MATERIAL_SYMBOLS, side[i]);
+            if (!symbol || !*symbol) {
+                return false;
+            }
+            int shift = materialShift(color, static_cast<int>(symbol - MATERIAL_SYMBOLS));
+            if ((key >> shift & 15) == 15) {
+                return false;
+            }
+            key += 1ULL << shift;
+        }
+    }
+    return true;
+}
+
+std::string materialSignature(uint64_t key) {
+    std::string signature;
+    for (int color = WHITE; color <= BLACK; ++color) {
+        signature += color == WHITE ? "K" : "vK";
+        for (int i = 0; i < MATERIAL_TYPE_COUNT; ++i) {
+            signature.append(key >> materialShift(color, i) & 15, MATERIAL_SYMBOLS[i]);
+        }
+    }
+    return signature;
+}
+
+ArchiveIndex::ArchiveIndex() : header(nullptr), games(nullptr), postingData(nullptr), terms(nullptr) {}
+
+bool ArchiveIndex::open(const std::string& filename) {
+    close();
+    if (!file.open(filename, true)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    header = reinterpret_cast<const ArchiveHeader*>(data);
+    bool valid = size >= sizeof(ArchiveHeader) &&
+                 std::memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0 &&
+                 header->version == ARCHIVE_VERSION &&
+                 size == sizeof(ArchiveHeader) + header->fileTableBytes + header->games * sizeof(ArchiveGame) +
+                         header->postingBytes + (header->positionTerms + header->materialTerms) * sizeof(ArchiveTerm);
+    
+    // The file table is a run of NUL-terminated names
+    const char* names = data + sizeof(ArchiveHeader);
+    const char* namesEnd = valid ? names + header->fileTableBytes : names;
+    for (uint32_t i = 0; valid && i < header->fileCount; ++i) {
+        const char* end = static_cast<const char*>(std::memchr(names, '\0', namesEnd - names));
+        if (!end) {
+            valid = false;
+            break;
+        }
+        fileNames.push_back(std::string(names, end));
+        names = end + 1;
+    }
+    if (!valid) {
+        std::cerr << "Error: " << filename << " is not an archive index.\n";
+        close();
+        return false;
+    }
+    
+    games = reinterpret_cast<const ArchiveGame*>(namesEnd);
+    postingData = reinterpret_cast<const unsigned char*>(games + header->games);
+    terms = reinterpret_cast<const ArchiveTerm*>(postingData + header->postingBytes);
+    return true;
+}
+
+void ArchiveIndex::close() {
+    file.close();
+    header = nullptr;
+    fileNames.clear();
+    games = nullptr;
+    postingData = nullptr;
+    terms = nullptr;
+}
+
+uint64_t ArchiveIndex::find(ArchiveTermKind kind, uint64_t key, std::vector<ArchivePosting>& postings, size_t limit) const {
+    postings.clear();
+    if (!isOpen()) {
+        return 0;
+    }
+    
+    const ArchiveTerm* end = terms + header->positionTerms + header->materialTerms;
+    std::pair<uint32_t, uint64_t> value(kind, key);
+    const ArchiveTerm* term = std::lower_bound(terms, end, value, termLess);
+    if (term == end || term->kind != static_cast<uint32_t>(kind) || term->key != key) {
+        return 0;
+    }
+    
+    size_t count = limit ? std::min<size_t>(limit, term->count) : term->count;
+    postings.reserve(count);
+    const unsigned char* in = postingData + term->postings;
+    uint32_t game = 0;
+    for (size_t i = 0; i < count; ++i) {
+        game += readVarint(in);
+        uint32_t ply = readVarint(in);
+        postings.push_back({game, ply});
+    }
+    return term->count;
+}
+
+bool ArchiveIndex::readGame(uint32_t game, PGNGame& pgn) const {
+    if (!isOpen() || game >= header->games) {
+        return false;
+    }
+    std::ifstream in(fileNames[games[game].file], std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    in.seekg(static_cast<std::streamoff>(games[game].offset));
+    return readPGNGame(in, pgn);
+}
+
+bool ArchiveIndexWriter::open(const std::string& filename, const std::vector<std::string>& files,
+                              const std::vector<ArchiveGame>& games) {
+    this->filename = filename;
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    termsOut.open(filename + ".terms", std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !termsOut.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for writing.\n";
+        return false;
+    }
+    
+    std::string fileTable;
+    for (const auto& name : files) {
+        fileTable += name;
+        fileTable += '\0';
+    }
+    fileTable.append((8 - fileTable.size() % 8) % 8, '\0');
+    
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    header.version = ARCHIVE_VERSION;
+    header.fileCount = static_cast<uint32_t>(files.size());
+    header.games = games.size();
+    header.fileTableBytes = fileTable.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Rewritten by finish()
+    out.write(fileTable.data(), fileTable.size());
+    out.write(reinterpret_cast<const char*>(games.data()), games.size() * sizeof(ArchiveGame));
+    return true;
+}
+
+void ArchiveIndexWriter::add(ArchiveTermKind kind, uint64_t key, const std::vector<ArchivePosting>& postings) {
+    buffer.clear();
+    uint32_t game = 0;
+    for (const auto& posting : postings) {
+        writeVarint(buffer, posting.game - game);
+        writeVarint(buffer, posting.ply);
+        game = posting.game;
+    }
+    
+    ArchiveTerm term;
+    term.key = key;
+    term.postings = header.postingBytes;
+    term.kind = kind;
+    term.count = static_cast<uint32_t>(postings.size());
+    termsOut.write(reinterpret_cast<const char*>(&term), sizeof(term));
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    header.postingBytes += buffer.size();
+    (kind == ARCHIVE_POSITION ? header.positionTerms : header.materialTerms)++;
+}
+
+bool ArchiveIndexWriter::finish() {
+    // Keeps the term table aligned
+    std::string padding((8 - header.postingBytes % 8) % 8, '\0');
+    out.write(padding.data(), padding.size());
+    header.postingBytes += padding.size();
+    
+    termsOut.close();
+    std::string termsFile = filename + ".terms";
+    if (header.positionTerms + header.materialTerms > 0) {
+        std::ifstream termsIn(termsFile, std::ios::binary);
+        out << termsIn.rdbuf();
+    }
+    std::remove(termsFile.c_str());
+    
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write " << filename << ".\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,189 @@
+#include "../include/Batch.h"
+#include "../include/EPD.h"
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t DEFAULT_NODES = 50000;
+const int MATE_CENTIPAWNS = 32767; // EPD convention: ce for a mate, less the plies to reach it
+
+struct BatchJob {
+    std::string line;
+    std::string output;
+    bool done;
+    bool counted; // A position was searched (not blank, a comment or invalid)
+};
+
+struct BatchQueue {
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable jobFinished;
+    std::deque<BatchJob*> pending;
+    bool done = false;
+};
+
+// Scores in centipawns from the side to move's point of view
+std::string evaluate(BatchJob& job, const SearchLimits& limits) {
+    // Blank and comment lines pass through; every other line gets an answer
+    size_t start = job.line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || job.line[start] == '#') {
+        return job.line;
+    }
+    std::string invalid = job.line + (job.line.back() == ';' ? " " : "; ") + "c0 \"invalid position\";";
+    
+    EPDRecord record;
+    if (!parseEPD(job.line, record)) {
+        return invalid;
+    }
+    
+    Game game;
+    if (!game.setFEN(record.toFEN())) {
+        return invalid;
+    }
+    
+    SearchResult result = game.search(limits);
+    bool white = game.isWhiteToMove();
+    int score = white ? result.score : -result.score;
+    int mateIn = white ? result.mateIn : -result.mateIn;
+    
+    std::ostringstream out;
+    out << record.position << " ";
+    std::string id = record.operation("id");
+    if (!id.empty()) {
+        out << "id " << id << "; ";
+    }
+    if (result.bestMove.first.first != -1) {
+        out << "bm " << moveToSAN(game.getBoard(), result.bestMove) << "; ";
+    }
+    if (mateIn != 0) {
+        int plies = mateIn > 0 ? 2 * mateIn - 1 : -2 * mateIn;
+        out << "ce " << (mateIn > 0 ? MATE_CENTIPAWNS - plies : plies - MATE_CENTIPAWNS) << "; ";
+        if (mateIn > 0) out << "dm " << mateIn << "; ";
+    } else {
+        out << "ce " << std::max(-MATE_CENTIPAWNS, std::min(MATE_CENTIPAWNS, score)) << "; ";
+    }
+    out << "acd " << result.depth << "; acn " << result.nodes << ";";
+    job.counted = true;
+    return out.str();
+}
+
+void batchWorker(BatchQueue& queue, const SearchLimits& limits) {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (true) {
+        queue.workAvailable.wait(lock, [&] { return !queue.pending.empty() || queue.done; });
+        if (queue.pending.empty()) {
+            return;
+        }
+        BatchJob* job = queue.pending.front();
+        queue.pending.pop_front();
+        lock.unlock();
+        
+        std::string output = evaluate(*job, limits);
+        
+        lock.lock();
+        job->output = output;
+        job->done = true;
+        queue.jobFinished.notify_all();
+    }
+}
+
+} // namespace
+
+int runBatch(int argc, char* argv[]) {
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    SearchLimits limits;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--batch") {
+            continue;
+        } else if (arg == "--threads" && hasValue) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--nodes" && hasValue) {
+            limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--movetime" && hasValue) {
+            limits.movetimeMs = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            limits.depth = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: chess --batch [--threads N] [--nodes N | --movetime ms | --depth N] < positions\n";
+            return 1;
+        }
+    }
+    if (!limits.depth && !limits.nodes && !limits.movetimeMs) {
+        limits.nodes = DEFAULT_NODES;
+    }
+    
+    BatchQueue queue;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(batchWorker, std::ref(queue), std::cref(limits));
+    }
+    
+    // Lines are read ahead of the writer, bounded so stdin can be an endless stream
+    const size_t maxInFlight = 8 * static_cast<size_t>(threads);
+    std::deque<std::unique_ptr<BatchJob>> inFlight;
+    uint64_t positions = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    // Writes finished jobs from the front of the window; called with the lock held
+    auto flush = [&]() {
+        bool wrote = false;
+        while (!inFlight.empty() && inFlight.front()->done) {
+            std::cout << inFlight.front()->output << "\n";
+            positions += inFlight.front()->counted ? 1 : 0;
+            inFlight.pop_front();
+            wrote = true;
+        }
+        if (wrote) std::cout.flush();
+    };
+    
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::unique_ptr<BatchJob> job(new BatchJob{line, "", false, false});
+        
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.pending.push_back(job.get());
+        inFlight.push_back(std::move(job));
+        queue.workAvailable.notify_one();
+        
+        flush();
+        while (inFlight.size() >= maxInFlight) {
+            queue.jobFinished.wait(lock);
+            flush();
+        }
+    }
+    
+    {
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.done = true;
+        queue.workAvailable.notify_all();
+        while (!inFlight.empty()) {
+            queue.jobFinished.wait(lock, [&] { return inFlight.front()->done; });
+            flush();
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Positions: " << positions << "\n"
+              << "Time: " << static_cast<int>(seconds * 1000) << " ms\n"
+              << "Positions/sec: " << static_cast<uint64_t>(seconds > 0 ? positions / seconds : 0) << "\n";
+    return 0;
+}
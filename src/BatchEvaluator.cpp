@@ -0,0 +1,245 @@
+#include "../include/BatchEvaluator.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHESS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const int TABLE_BYTES = 256;
+const int TYPE_TABLE_SIZE = 8 * TABLE_BYTES;
+const int TRIPLE_GROUPS = 11; // 3-bit groups per 32-bit half; the last one overlaps the one before
+const int NIBBLE_GROUPS = 8;  // 4-bit groups per 32-bit half
+
+// Bit offset of group k within a half; groups end at bit 32
+inline int groupShift(int k, int groupBits) {
+    return std::min(k * groupBits, 32 - groupBits);
+}
+
+// First of the tables for one color's pieces of a type: one per group of each half, in order
+inline size_t groupTableStart(int color, int type, int groupBits, int groups) {
+    return static_cast<size_t>((color * PIECE_TYPE_COUNT + type) * 2 * groups) << groupBits;
+}
+
+// Tables for lookups by groups of groupBits bits: the entry for a group's bits is the sum of the
+// material and piece-square values of those pieces. Bits shared with the previous group
+// (see groupShift) count only there.
+std::vector<int32_t> buildGroupTables(const EvalParams& params, int groupBits, int groups) {
+    int entries = 1 << groupBits;
+    std::vector<int32_t> tables(groupTableStart(COLOR_COUNT, 0, groupBits, groups));
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            int32_t* table = &tables[groupTableStart(c, t, groupBits, groups)];
+            for (int h = 0; h < 2; ++h) {
+                for (int k = 0; k < groups; ++k, table += entries) {
+                    int shift = groupShift(k, groupBits);
+                    for (int bits = 0; bits < entries; ++bits) {
+                        for (int i = 0; i < groupBits; ++i) {
+                            if (bits & (1 << i) && shift + i >= k * groupBits) {
+                                int square = relativeSquare(c, 32 * h + shift + i);
+                                table[bits] += params.pieceValues[t] + params.pieceSquare[t][square];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return tables;
+}
+
+} // namespace
+
+void PositionBatch::clear() {
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            bitboards[c][t].clear();
+        }
+    }
+    count = 0;
+}
+
+void PositionBatch::reserve(size_t positions) {
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            bitboards[c][t].reserve(positions);
+        }
+    }
+}
+
+void PositionBatch::add(const Board& board) {
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            bitboards[c][t].push_back(board.getPieces(c == WHITE, static_cast<PieceType>(t)));
+        }
+    }
+    count++;
+}
+
+bool PositionBatch::add(const PackedPosition& packed) {
+    Bitboard pieces[COLOR_COUNT][PIECE_TYPE_COUNT] = {};
+    Bitboard occupied = packed.occupancy;
+    for (int i = 0; occupied; ++i) {
+        int square = popLowestSquare(occupied);
+        PieceCode code = static_cast<PieceCode>(i < 32 ? packed.pieces[i / 2] >> (i % 2 * 4) & 15 : NO_PIECE);
+        int type = pieceCodeType(code);
+        if (type < 0 || type >= PIECE_TYPE_COUNT) {
+            return false;
+        }
+        pieces[pieceCodeColor(code)][type] |= squareBit(square);
+    }
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            bitboards[c][t].push_back(pieces[c][t]);
+        }
+    }
+    count++;
+    return true;
+}
+
+SimdLevel detectSimdLevel() {
+#ifdef CHESS_X86_SIMD
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+BatchEvaluator::BatchEvaluator(const EvalParams& params)
+    : rankTables(PIECE_TYPE_COUNT * TYPE_TABLE_SIZE),
+      tripleTables(buildGroupTables(params, 3, TRIPLE_GROUPS)),
+      nibbleTables(buildGroupTables(params, 4, NIBBLE_GROUPS)),
+      level(detectSimdLevel()) {
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        for (int rank = 0; rank < 8; ++rank) {
+            for (int byte = 0; byte < TABLE_BYTES; ++byte) {
+                int32_t value = 0;
+                for (int file = 0; file < 8; ++file) {
+                    if (byte & (1 << file)) {
+                        value += params.pieceValues[t] + params.pieceSquare[t][rank * 8 + file];
+                    }
+                }
+                rankTables[t * TYPE_TABLE_SIZE + rank * TABLE_BYTES + byte] = value;
+            }
+        }
+    }
+}
+
+void BatchEvaluator::evaluate(const PositionBatch& batch, int* scores) const {
+    evaluate(batch, scores, level);
+}
+
+void BatchEvaluator::evaluate(const PositionBatch& batch, int* scores, SimdLevel level) const {
+    size_t done = 0;
+    if (level == SimdLevel::AVX512) {
+        done = evaluateAVX512(batch, scores);
+    } else if (level == SimdLevel::AVX2) {
+        done = evaluateAVX2(batch, scores);
+    }
+    evaluateScalar(batch, done, scores);
+}
+
+// Byte r of a bitboard is rank 8 - r. Black's pieces use the table of the mirrored rank.
+void BatchEvaluator::evaluateScalar(const PositionBatch& batch, size_t begin, int* scores) const {
+    for (size_t i = begin; i < batch.size(); ++i) {
+        int score = 0;
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            const int32_t* table = &rankTables[t * TYPE_TABLE_SIZE];
+            Bitboard white = batch.pieces(WHITE, t)[i];
+            Bitboard black = batch.pieces(BLACK, t)[i];
+            for (int rank = 0; rank < 8; ++rank) {
+                score += table[rank * TABLE_BYTES + (white >> (8 * rank) & 0xFF)];
+                score -= table[(7 - rank) * TABLE_BYTES + (black >> (8 * rank) & 0xFF)];
+            }
+        }
+        scores[i] = score;
+    }
+}
+
+#ifdef CHESS_X86_SIMD
+
+// Each step splits the bitboards of 8 positions into 32-bit halves (ranks 8-5 and ranks 4-1) and
+// looks up 3-bit groups of every half at once: vpermd indexes an 8-entry table by the low 3 bits
+// of each lane, so shifting the half is all the indexing needed
+__attribute__((target("avx2")))
+size_t BatchEvaluator::evaluateAVX2(const PositionBatch& batch, int* scores) const {
+    const __m256i evenOdd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    size_t end = batch.size() / 8 * 8;
+    for (size_t i = 0; i < end; i += 8) {
+        __m256i score = _mm256_setzero_si256();
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            for (int c = 0; c < COLOR_COUNT; ++c) {
+                const Bitboard* bitboards = batch.pieces(c, t) + i;
+                __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitboards)), evenOdd);
+                __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitboards + 4)), evenOdd);
+                __m256i halves[2] = { _mm256_permute2x128_si256(a, b, 0x20), _mm256_permute2x128_si256(a, b, 0x31) };
+                const int* table = &tripleTables[groupTableStart(c, t, 3, TRIPLE_GROUPS)];
+                __m256i sum = _mm256_setzero_si256();
+                for (int h = 0; h < 2; ++h) {
+                    for (int k = 0; k < TRIPLE_GROUPS; ++k, table += 8) {
+                        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table));
+                        __m256i bits = _mm256_srli_epi32(halves[h], groupShift(k, 3));
+                        sum = _mm256_add_epi32(sum, _mm256_permutevar8x32_epi32(values, bits));
+                    }
+                }
+                score = c == WHITE ? _mm256_add_epi32(score, sum) : _mm256_sub_epi32(score, sum);
+            }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(scores + i), score);
+    }
+    return end;
+}
+
+// As evaluateAVX2, with 16 positions per step and 16-entry tables indexed by 4-bit groups
+__attribute__((target("avx512f")))
+size_t BatchEvaluator::evaluateAVX512(const PositionBatch& batch, int* scores) const {
+    size_t end = batch.size() / 16 * 16;
+    for (size_t i = 0; i < end; i += 16) {
+        __m512i score = _mm512_setzero_si512();
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            for (int c = 0; c < COLOR_COUNT; ++c) {
+                const Bitboard* bitboards = batch.pieces(c, t) + i;
+                __m512i a = _mm512_loadu_si512(bitboards);
+                __m512i b = _mm512_loadu_si512(bitboards + 8);
+                __m512i halves[2] = {
+                    _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(a)), _mm512_cvtepi64_epi32(b), 1),
+                    _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(_mm512_srli_epi64(a, 32))),
+                                       _mm512_cvtepi64_epi32(_mm512_srli_epi64(b, 32)), 1)
+                };
+                const int* table = &nibbleTables[groupTableStart(c, t, 4, NIBBLE_GROUPS)];
+                __m512i sum = _mm512_setzero_si512();
+                for (int h = 0; h < 2; ++h) {
+                    for (int k = 0; k < NIBBLE_GROUPS; ++k, table += 16) {
+                        __m512i bits = _mm512_srli_epi32(halves[h], groupShift(k, 4));
+                        sum = _mm512_add_epi32(sum, _mm512_permutexvar_epi32(bits, _mm512_loadu_si512(table)));
+                    }
+                }
+                score = c == WHITE ? _mm512_add_epi32(score, sum) : _mm512_sub_epi32(score, sum);
+            }
+        }
+        _mm512_storeu_si512(scores + i, score);
+    }
+    return end;
+}
+
+#else
+
+size_t BatchEvaluator::evaluateAVX2(const PositionBatch&, int*) const {
+    return 0;
+}
+
+size_t BatchEvaluator::evaluateAVX512(const PositionBatch&, int*) const {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include "../include/Bitboard.h"
+
+namespace {
+
+// Ray directions as (row, column) steps; the first four increase the square index
+const int DIRECTION_DX[8] = { 1,  0,  1,  1, -1,  0, -1, -1 };
+const int DIRECTION_DY[8] = { 0,  1,  1, -1,  0, -1, -1,  1 };
+const int FIRST_NEGATIVE_DIRECTION = 4;
+
+struct AttackTables {
+    Bitboard pawn[COLOR_COUNT][64];
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard rays[8][64]; // Squares from (exclusive) a square to the edge in each direction
+    Bitboard between[64][64];
+    Bitboard line[64][64];
+
+    AttackTables() {
+        const int knightDX[8] = { -2, -2, -1, -1, 1, 1, 2, 2 };
+        const int knightDY[8] = { -1, 1, -2, 2, -2, 2, -1, 1 };
+        
+        for (int x = 0; x < 8; ++x) {
+            for (int y = 0; y < 8; ++y) {
+                int square = squareIndex(x, y);
+                pawn[WHITE][square] = offsetBit(x - 1, y - 1) | offsetBit(x - 1, y + 1);
+                pawn[BLACK][square] = offsetBit(x + 1, y - 1) | offsetBit(x + 1, y + 1);
+                
+                knight[square] = 0;
+                for (int i = 0; i < 8; ++i) {
+                    knight[square] |= offsetBit(x + knightDX[i], y + knightDY[i]);
+                }
+                
+                king[square] = 0;
+                for (int dir = 0; dir < 8; ++dir) {
+                    king[square] |= offsetBit(x + DIRECTION_DX[dir], y + DIRECTION_DY[dir]);
+                    
+                    rays[dir][square] = 0;
+                    for (int step = 1; step < 8; ++step) {
+                        rays[dir][square] |= offsetBit(x + step * DIRECTION_DX[dir], y + step * DIRECTION_DY[dir]);
+                    }
+                }
+            }
+        }
+        
+        for (int from = 0; from < 64; ++from) {
+            for (int to = 0; to < 64; ++to) {
+                between[from][to] = 0;
+                line[from][to] = 0;
+            }
+            for (int dir = 0; dir < 8; ++dir) {
+                // Opposite directions differ in bit 2 (down/up, right/left, ...)
+                Bitboard fullLine = rays[dir][from] | rays[dir ^ 4][from] | squareBit(from);
+                int x = from / 8 + DIRECTION_DX[dir];
+                int y = from % 8 + DIRECTION_DY[dir];
+                Bitboard path = 0;
+                for (; x >= 0 && x < 8 && y >= 0 && y < 8; x += DIRECTION_DX[dir], y += DIRECTION_DY[dir]) {
+                    int to = squareIndex(x, y);
+                    between[from][to] = path;
+                    line[from][to] = fullLine;
+                    path |= squareBit(to);
+                }
+            }
+        }
+    }
+
+    static Bitboard offsetBit(int x, int y) {
+        return (x >= 0 && x < 8 && y >= 0 && y < 8) ? squareBit(x, y) : 0;
+    }
+};
+
+const AttackTables TABLES;
+
+// Classical ray attacks: cut each ray at its nearest blocker
+inline Bitboard rayAttacks(int dir, int square, Bitboard occupied) {
+    Bitboard attacks = TABLES.rays[dir][square];
+    Bitboard blockers = attacks & occupied;
+    if (blockers) {
+        int blocker = dir < FIRST_NEGATIVE_DIRECTION ? lowestSquare(blockers) : 63 - __builtin_clzll(blockers);
+        attacks ^= TABLES.rays[dir][blocker];
+    }
+    return attacks;
+}
+
+} // namespace
+
+PieceType pieceTypeFromSymbol(char symbol) {
+    switch (symbol) {
+        case 'P': case 'p': return PAWN;
+        case 'N': case 'n': return KNIGHT;
+        case 'B': case 'b': return BISHOP;
+        case 'R': case 'r': return ROOK;
+        case 'Q': case 'q': return QUEEN;
+        case 'K': case 'k': return KING;
+        default: return PIECE_TYPE_COUNT;
+    }
+}
+
+PieceCode pieceCodeFromSymbol(char symbol) {
+    PieceType type = pieceTypeFromSymbol(symbol);
+    if (type == PIECE_TYPE_COUNT) return NO_PIECE;
+    return makePieceCode(symbol >= 'a' ? BLACK : WHITE, type);
+}
+
+char pieceCodeSymbol(PieceCode code) {
+    if (code == NO_PIECE) return ' ';
+    const char* symbols = "PNBRQK";
+    char symbol = symbols[pieceCodeType(code)];
+    return pieceCodeColor(code) == WHITE ? symbol : static_cast<char>(symbol - 'A' + 'a');
+}
+
+Bitboard pawnAttacks(bool isWhite, int square) {
+    return TABLES.pawn[colorIndex(isWhite)][square];
+}
+
+Bitboard knightAttacks(int square) {
+    return TABLES.knight[square];
+}
+
+Bitboard kingAttacks(int square) {
+    return TABLES.king[square];
+}
+
+Bitboard bishopAttacks(int square, Bitboard occupied) {
+    // Diagonals: down-right, down-left, up-left, up-right
+    return rayAttacks(2, square, occupied) | rayAttacks(3, square, occupied) |
+           rayAttacks(6, square, occupied) | rayAttacks(7, square, occupied);
+}
+
+Bitboard rookAttacks(int square, Bitboard occupied) {
+    // Orthogonals: down, right, up, left
+    return rayAttacks(0, square, occupied) | rayAttacks(1, square, occupied) |
+           rayAttacks(4, square, occupied) | rayAttacks(5, square, occupied);
+}
+
+Bitboard queenAttacks(int square, Bitboard occupied) {
+    return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+Bitboard betweenSquares(int from, int to) {
+    return TABLES.between[from][to];
+}
+
+Bitboard lineThrough(int from, int to) {
+    return TABLES.line[from][to];
+}
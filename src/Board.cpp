@@ -5,117 +5,205 @@
 #include "Pieces/Bishop.h"
 #include "Pieces/Queen.h"
 #include "Pieces/King.h"
+#include "../include/Evaluation.h"
+#include "../include/Zobrist.h"
+#include "../include/Trace.h"
 #include <iostream>
 #include <algorithm>
+#include <sstream>
 
-Board::Board() : gameOver(false), gameStatus("ongoing"), enPassantTarget(-1, -1) {
+Board::Board() : gameOver(false), gameStatus("ongoing"), castlingRights(0), enPassantTarget(-1, -1),
+                 whiteToMove(true), halfmoveClock(0), zobristKey(0) {
+    clearPieces();
     resetBoard();
 }
 
-Board::Board(const Board& other) : gameOver(other.gameOver), gameStatus(other.gameStatus), 
-                                   movedPieces(other.movedPieces), enPassantTarget(other.enPassantTarget) {
-    // Initialize board with nullptr
-    for (auto &row : board) {
-        row.fill(nullptr);
-    }
-    
-    // Copy pieces
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (other.board[i][j]) {
-                board[i][j] = createPieceCopy(other.board[i][j]);
-            }
-        }
-    }
+Board::Board(const Board& other) : squares(other.squares), gameOver(other.gameOver), gameStatus(other.gameStatus), 
+                                   castlingRights(other.castlingRights), enPassantTarget(other.enPassantTarget),
+                                   whiteToMove(other.whiteToMove), halfmoveClock(other.halfmoveClock),
+                                   zobristKey(other.zobristKey) {
+    std::copy(&other.pieceBitboards[0][0], &other.pieceBitboards[0][0] + COLOR_COUNT * PIECE_TYPE_COUNT,
+              &pieceBitboards[0][0]);
+    std::copy(other.colorOccupancy, other.colorOccupancy + COLOR_COUNT, colorOccupancy);
+    invalidateAttackMaps();
 }
 
 Board::~Board() {
-    // Clean up all pieces
-    for (auto &row : board) {
-        for (auto &piece : row) {
-            delete piece;
-        }
-    }
+    // Pieces are owned by sharedPiece(), nothing to free
 }
 
 Board& Board::operator=(const Board& other) {
     if (this != &other) {
-        // Clean up existing pieces
-        for (auto &row : board) {
-            for (auto &piece : row) {
-                delete piece;
-            }
-        }
-        
-        // Copy new pieces
-        for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                if (other.board[i][j]) {
-                    board[i][j] = createPieceCopy(other.board[i][j]);
-                } else {
-                    board[i][j] = nullptr;
-                }
-            }
-        }
-        
+        squares = other.squares;
+        std::copy(&other.pieceBitboards[0][0], &other.pieceBitboards[0][0] + COLOR_COUNT * PIECE_TYPE_COUNT,
+                  &pieceBitboards[0][0]);
+        std::copy(other.colorOccupancy, other.colorOccupancy + COLOR_COUNT, colorOccupancy);
         gameOver = other.gameOver;
         gameStatus = other.gameStatus;
-        movedPieces = other.movedPieces;
+        castlingRights = other.castlingRights;
         enPassantTarget = other.enPassantTarget;
+        whiteToMove = other.whiteToMove;
+        halfmoveClock = other.halfmoveClock;
+        zobristKey = other.zobristKey;
+        invalidateAttackMaps();
     }
     return *this;
 }
 
-Piece* Board::createPieceCopy(Piece* original) const {
-    if (!original) return nullptr;
-    
-    char symbol = original->getSymbol();
-    bool isWhite = original->isWhite();
-    
-    switch (symbol) {
-        case 'P': case 'p':
-            return new Pawn(isWhite);
-        case 'R': case 'r':
-            return new Rook(isWhite);
-        case 'N': case 'n':
-            return new Knight(isWhite);
-        case 'B': case 'b':
-            return new Bishop(isWhite);
-        case 'Q': case 'q':
-            return new Queen(isWhite);
-        case 'K': case 'k':
-            return new King(isWhite);
-        default:
-            return nullptr;
+namespace {
+
+// Pieces carry no per-square state, so one immortal instance per kind and colour
+// serves every board (and every thread: all Piece methods are const)
+struct PieceSet {
+    Pawn whitePawn{true}, blackPawn{false};
+    Rook whiteRook{true}, blackRook{false};
+    Knight whiteKnight{true}, blackKnight{false};
+    Bishop whiteBishop{true}, blackBishop{false};
+    Queen whiteQueen{true}, blackQueen{false};
+    King whiteKing{true}, blackKing{false};
+    Piece* byCode[PIECE_CODE_COUNT];
+    
+    PieceSet() : byCode() {
+        byCode[makePieceCode(WHITE, PAWN)] = &whitePawn;
+        byCode[makePieceCode(BLACK, PAWN)] = &blackPawn;
+        byCode[makePieceCode(WHITE, ROOK)] = &whiteRook;
+        byCode[makePieceCode(BLACK, ROOK)] = &blackRook;
+        byCode[makePieceCode(WHITE, KNIGHT)] = &whiteKnight;
+        byCode[makePieceCode(BLACK, KNIGHT)] = &blackKnight;
+        byCode[makePieceCode(WHITE, BISHOP)] = &whiteBishop;
+        byCode[makePieceCode(BLACK, BISHOP)] = &blackBishop;
+        byCode[makePieceCode(WHITE, QUEEN)] = &whiteQueen;
+        byCode[makePieceCode(BLACK, QUEEN)] = &blackQueen;
+        byCode[makePieceCode(WHITE, KING)] = &whiteKing;
+        byCode[makePieceCode(BLACK, KING)] = &blackKing;
     }
+};
+
+} // namespace
+
+Piece* Board::sharedPiece(PieceCode code) {
+    static PieceSet pieces;
+    return pieces.byCode[code & (PIECE_CODE_COUNT - 1)];
 }
 
-void Board::resetBoard() {
-    for (auto &row : board) {
-        row.fill(nullptr); // Initialize all squares to nullptr
+void Board::clearPieces() {
+    invalidateAttackMaps();
+    squares.fill(NO_PIECE);
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        colorOccupancy[c] = 0;
+        for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+            pieceBitboards[c][t] = 0;
+        }
     }
+}
+
+void Board::putPiece(int square, PieceCode code) {
+    int color = pieceCodeColor(code);
+    int type = pieceCodeType(code);
+    squares[square] = code;
+    pieceBitboards[color][type] |= squareBit(square);
+    colorOccupancy[color] |= squareBit(square);
+    zobristKey ^= zobristPieceKey(color, type, square);
+}
+
+void Board::removePiece(int square) {
+    PieceCode code = squares[square];
+    int color = pieceCodeColor(code);
+    int type = pieceCodeType(code);
+    squares[square] = NO_PIECE;
+    pieceBitboards[color][type] &= ~squareBit(square);
+    colorOccupancy[color] &= ~squareBit(square);
+    zobristKey ^= zobristPieceKey(color, type, square);
+}
+
+void Board::resetBoard() {
+    clearPieces();
     setupPieces();
     gameOver = false;
     gameStatus = "ongoing";
+    castlingRights = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE;
+    enPassantTarget = {-1, -1};
+    whiteToMove = true;
+    halfmoveClock = 0;
+    zobristKey = computeZobristKey();
+}
+
+bool Board::loadFEN(const std::string& fen) {
+    std::istringstream iss(fen);
+    std::string position, activeColor, castling, enPassant;
+    int halfmove = 0;
+    if (!(iss >> position >> activeColor) || (activeColor != "w" && activeColor != "b")) {
+        return false;
+    }
+    if (!(iss >> castling)) castling = "-";
+    if (!(iss >> enPassant)) enPassant = "-";
+    if (!(iss >> halfmove) || halfmove < 0) halfmove = 0;
+    
+    // Validate the placement field before touching the board
+    int row = 0, col = 0;
+    for (char c : position) {
+        if (c == '/') {
+            if (col != 8) return false;
+            row++;
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            col += c - '0';
+        } else if (std::string("PNBRQKpnbrqk").find(c) != std::string::npos) {
+            col++;
+        } else {
+            return false;
+        }
+        if (col > 8 || row > 7) return false;
+    }
+    if (row != 7 || col != 8) return false;
+    
+    // Place pieces
+    clearPieces();
+    row = 0;
+    col = 0;
+    for (char c : position) {
+        if (c == '/') {
+            row++;
+            col = 0;
+        } else if (isdigit(c)) {
+            col += c - '0';
+        } else {
+            putPiece(squareIndex(row, col), pieceCodeFromSymbol(c));
+            col++;
+        }
+    }
+    
+    // Castling rights
+    castlingRights = 0;
+    if (castling.find('K') != std::string::npos) castlingRights |= WHITE_KINGSIDE;
+    if (castling.find('Q') != std::string::npos) castlingRights |= WHITE_QUEENSIDE;
+    if (castling.find('k') != std::string::npos) castlingRights |= BLACK_KINGSIDE;
+    if (castling.find('q') != std::string::npos) castlingRights |= BLACK_QUEENSIDE;
+    
+    // En passant target square
+    enPassantTarget = {-1, -1};
+    if (enPassant.length() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' &&
+        (enPassant[1] == '3' || enPassant[1] == '6')) {
+        enPassantTarget = {8 - (enPassant[1] - '0'), enPassant[0] - 'a'};
+    }
+    
+    whiteToMove = (activeColor == "w");
+    halfmoveClock = halfmove;
+    gameOver = false;
+    gameStatus = "ongoing";
+    zobristKey = computeZobristKey();
+    return true;
 }
 
 void Board::setupPieces() {
+    const char* whiteBackRank = "RNBQKBNR";
+    const char* blackBackRank = "rnbqkbnr";
     for (int i = 0; i < 8; ++i) {
-        board[6][i] = new Pawn(true);  // White Pawns (row 6)
-        board[1][i] = new Pawn(false); // Black Pawns (row 1)
+        putPiece(squareIndex(6, i), makePieceCode(WHITE, PAWN)); // White Pawns (row 6)
+        putPiece(squareIndex(1, i), makePieceCode(BLACK, PAWN)); // Black Pawns (row 1)
+        putPiece(squareIndex(7, i), pieceCodeFromSymbol(whiteBackRank[i]));
+        putPiece(squareIndex(0, i), pieceCodeFromSymbol(blackBackRank[i]));
     }
-
-    board[7][0] = new Rook(true); board[7][7] = new Rook(true);
-    board[0][0] = new Rook(false); board[0][7] = new Rook(false);
-
-    board[7][1] = new Knight(true); board[7][6] = new Knight(true);
-    board[0][1] = new Knight(false); board[0][6] = new Knight(false);
-
-    board[7][2] = new Bishop(true); board[7][5] = new Bishop(true);
-    board[0][2] = new Bishop(false); board[0][5] = new Bishop(false);
-
-    board[7][3] = new Queen(true); board[7][4] = new King(true);
-    board[0][3] = new Queen(false); board[0][4] = new King(false);
 }
 
 void Board::printBoard() const {
@@ -126,8 +214,8 @@ void Board::printBoard() const {
     for (int i = 0; i < 8; ++i) {
         std::cout << " " << (8-i) << " |";
         for (int j = 0; j < 8; ++j) {
-            if (board[i][j]) {
-                std::cout << " " << board[i][j]->getSymbol() << " |";
+            if (squares[squareIndex(i, j)]) {
+                std::cout << " " << pieceCodeSymbol(squares[squareIndex(i, j)]) << " |";
             } else {
                 // Create alternating colors for empty squares
                 if ((i + j) % 2 == 0) {
@@ -153,20 +241,36 @@ void Board::printBoard() const {
 
 Piece* Board::getPiece(int x, int y) const {
     if (x < 0 || x >= 8 || y < 0 || y >= 8) return nullptr;
-    return board[x][y];
+    return sharedPiece(squares[squareIndex(x, y)]);
+}
+
+PieceCode Board::getPieceCode(int x, int y) const {
+    if (x < 0 || x >= 8 || y < 0 || y >= 8) return NO_PIECE;
+    return squares[squareIndex(x, y)];
 }
 
 void Board::movePiece(int x1, int y1, int x2, int y2) {
-    // Handle en passant
-    if (board[x1][y1] && board[x1][y1]->getSymbol() == (board[x1][y1]->isWhite() ? 'P' : 'p')) {
-        Pawn* pawn = dynamic_cast<Pawn*>(board[x1][y1]);
-        if (pawn && pawn->isEnPassantMove(x1, y1, x2, y2, *this)) {
+    TRACE_SCOPE("make");
+    int from = squareIndex(x1, y1);
+    int to = squareIndex(x2, y2);
+    PieceCode moving = squares[from];
+    if (!moving) return;
+    invalidateAttackMaps();
+    
+    bool moverIsWhite = pieceCodeColor(moving) == WHITE;
+    int type = pieceCodeType(moving);
+    bool isPawnMove = type == PAWN;
+    bool isCapture = squares[to] != NO_PIECE;
+    bool handled = false;
+    
+    // Handle en passant: a diagonal pawn step onto an empty square
+    if (isPawnMove) {
+        if (y1 != y2 && !isCapture && canEnPassant(x1, y1, x2, y2)) {
             performEnPassant(x1, y1, x2, y2);
-            return;
-        }
-        
-        // Set en passant target if pawn moves two squares
-        if (abs(x2 - x1) == 2 && y1 == y2) {
+            isCapture = true;
+            handled = true;
+        } else if (abs(x2 - x1) == 2 && y1 == y2) {
+            // Set en passant target if pawn moves two squares
             setEnPassantTarget((x1 + x2) / 2, y1);
         } else {
             clearEnPassantTarget();
@@ -175,163 +279,130 @@ void Board::movePiece(int x1, int y1, int x2, int y2) {
         clearEnPassantTarget();
     }
     
-    // Handle castling
-    if (board[x1][y1] && board[x1][y1]->getSymbol() == (board[x1][y1]->isWhite() ? 'K' : 'k')) {
-        King* king = dynamic_cast<King*>(board[x1][y1]);
-        if (king && king->isCastlingMove(x1, y1, x2, y2)) {
-            bool isKingSide = (y2 > y1);
-            performCastling(board[x1][y1]->isWhite(), isKingSide);
-            return;
+    // Handle castling: a two-square king move from its starting square, when castling is allowed
+    if (!handled && type == KING && x1 == x2 && x1 == (moverIsWhite ? 7 : 0) && y1 == 4 && abs(y2 - y1) == 2) {
+        handled = performCastling(moverIsWhite, y2 > y1);
+    }
+    
+    if (!handled) {
+        // Moving a king or rook, or capturing a rook on its corner, drops castling rights
+        recordPieceMovement(x1, y1);
+        recordPieceMovement(x2, y2);
+        
+        if (isCapture) {
+            removePiece(to);
+        }
+        removePiece(from);
+        
+        // Handle pawn promotion: white reaches row 0, black reaches row 7
+        if (isPawnMove && x2 == (moverIsWhite ? 0 : 7)) {
+            moving = makePieceCode(pieceCodeColor(moving), QUEEN);
         }
+        putPiece(to, moving);
     }
     
-    // Record that the piece has moved (for regular moves)
-    recordPieceMovement(x1, y1);
-    
-    // Handle pawn promotion
-    if (board[x1][y1] && board[x1][y1]->getSymbol() == 'P' && x2 == 0) {
-        // White pawn reaching the top (row 0)
-        delete board[x1][y1];
-        board[x2][y2] = new Queen(true);
-        board[x1][y1] = nullptr;
-    } else if (board[x1][y1] && board[x1][y1]->getSymbol() == 'p' && x2 == 7) {
-        // Black pawn reaching the bottom (row 7)
-        delete board[x1][y1];
-        board[x2][y2] = new Queen(false);
-        board[x1][y1] = nullptr;
-    } else {
-        // Regular move
-        board[x2][y2] = board[x1][y1];
-        board[x1][y1] = nullptr;
+    halfmoveClock = (isPawnMove || isCapture) ? 0 : halfmoveClock + 1;
+    if (whiteToMove == moverIsWhite) {
+        whiteToMove = !moverIsWhite;
+        zobristKey ^= zobristSideKey();
     }
 }
 
 std::pair<int, int> Board::findKing(bool isWhiteKing) const {
-    char kingSymbol = isWhiteKing ? 'K' : 'k';
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (board[i][j] && board[i][j]->getSymbol() == kingSymbol) {
-                return {i, j};
-            }
-        }
+    Bitboard king = getPieces(isWhiteKing, KING);
+    if (!king) {
+        return {-1, -1}; // King not found (shouldn't happen in valid game)
     }
-    return {-1, -1}; // King not found (shouldn't happen in valid game)
+    int square = lowestSquare(king);
+    return {square / 8, square % 8};
 }
 
 bool Board::isSquareUnderAttack(int x, int y, bool byWhite) const {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (board[i][j] && board[i][j]->isWhite() == byWhite) {
-                if (board[i][j]->isValidMove(i, j, x, y, *this)) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    if (x < 0 || x >= 8 || y < 0 || y >= 8) return false;
+    return (getAttackedSquares(byWhite) & squareBit(x, y)) != 0;
 }
 
 bool Board::isCheck(bool isWhiteKing) const {
-    auto kingPos = findKing(isWhiteKing);
-    if (kingPos.first == -1) return false;
-    return isSquareUnderAttack(kingPos.first, kingPos.second, !isWhiteKing);
-}
-
-bool Board::canMoveWithoutLeavingCheck(int x1, int y1, int x2, int y2, bool isWhiteKing) const {
-    // Create a temporary board to test the move
-    Board tempBoard = *this;
-    
-    // Make the move on temporary board
-    tempBoard.board[x2][y2] = tempBoard.board[x1][y1];
-    tempBoard.board[x1][y1] = nullptr;
-    
-    // Check if the king is still in check after the move
-    return !tempBoard.isCheck(isWhiteKing);
+    Bitboard king = getPieces(isWhiteKing, KING);
+    if (!king) return false;
+    int square = lowestSquare(king);
+    return getAttackersTo(square / 8, square % 8, !isWhiteKing) != 0;
 }
 
 bool Board::isValidMove(int x1, int y1, int x2, int y2) const {
+    TRACE_SCOPE("legality");
     // Basic validation
     if (x1 < 0 || x1 >= 8 || y1 < 0 || y1 >= 8 || 
         x2 < 0 || x2 >= 8 || y2 < 0 || y2 >= 8) {
         return false;
     }
     
-    Piece* piece = board[x1][y1];
-    if (!piece) return false;
-    
-    // Check if destination has own piece
-    Piece* destPiece = board[x2][y2];
-    if (destPiece && destPiece->isWhite() == piece->isWhite()) {
-        return false;
-    }
-    
-    // Check if the move is valid for the piece
-    if (!piece->isValidMove(x1, y1, x2, y2, *this)) {
-        return false;
-    }
+    if (!squares[squareIndex(x1, y1)]) return false;
     
-    // Check if the move doesn't leave own king in check
-    return canMoveWithoutLeavingCheck(x1, y1, x2, y2, piece->isWhite());
+    // Legal destinations already exclude own pieces and moves leaving the king in check
+    return (legalTargets(squareIndex(x1, y1)) & squareBit(x2, y2)) != 0;
 }
 
 std::vector<std::pair<int, int>> Board::getLegalMoves(int x, int y) const {
     std::vector<std::pair<int, int>> legalMoves;
-    Piece* piece = board[x][y];
-    if (!piece) return legalMoves;
+    if (x < 0 || x >= 8 || y < 0 || y >= 8 || !squares[squareIndex(x, y)]) return legalMoves;
     
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (isValidMove(x, y, i, j)) {
-                legalMoves.push_back({i, j});
-            }
-        }
+    Bitboard targets = legalTargets(squareIndex(x, y));
+    while (targets) {
+        int square = popLowestSquare(targets);
+        legalMoves.push_back({square / 8, square % 8});
     }
     return legalMoves;
 }
 
+void Board::generateLegalMoves(bool forWhite, std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& moves) const {
+    TRACE_SCOPE("movegen");
+    int us = colorIndex(forWhite);
+    if (!checkInfoValid[us]) computeCheckInfo(us);
+    
+    size_t before = moves.size();
+    if (forWhite) {
+        generateAll<WHITE>(moves);
+    } else {
+        generateAll<BLACK>(moves);
+    }
+    legalMoveState[us] = moves.size() > before ? 1 : 0;
+}
+
 bool Board::hasLegalMoves(bool isWhiteKing) const {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (board[i][j] && board[i][j]->isWhite() == isWhiteKing) {
-                if (!getLegalMoves(i, j).empty()) {
-                    return true;
-                }
-            }
-        }
+    TRACE_SCOPE("movegen");
+    int us = colorIndex(isWhiteKing);
+    if (legalMoveState[us] != -1) {
+        return legalMoveState[us] == 1;
     }
-    return false;
+    if (!checkInfoValid[us]) computeCheckInfo(us);
+    
+    bool found = isWhiteKing ? hasAnyLegalMove<WHITE>() : hasAnyLegalMove<BLACK>();
+    legalMoveState[us] = found ? 1 : 0;
+    return found;
 }
 
 bool Board::isCheckmate(bool isWhiteKing) const {
-    return isCheck(isWhiteKing) && !hasLegalMoves(isWhiteKing);
+    return getCheckers(isWhiteKing) && !hasLegalMoves(isWhiteKing);
 }
 
 bool Board::isStalemate(bool isWhiteKing) const {
-    return !isCheck(isWhiteKing) && !hasLegalMoves(isWhiteKing);
+    return !getCheckers(isWhiteKing) && !hasLegalMoves(isWhiteKing);
 }
 
 void Board::promotePawn(int x, int y, char pieceType) {
-    if (!board[x][y]) return;
+    int square = squareIndex(x, y);
+    if (!squares[square]) return;
     
-    bool isWhite = board[x][y]->isWhite();
-    delete board[x][y];
+    int color = pieceCodeColor(squares[square]);
+    removePiece(square);
+    invalidateAttackMaps();
     
-    switch (pieceType) {
-        case 'Q': case 'q':
-            board[x][y] = new Queen(isWhite);
-            break;
-        case 'R': case 'r':
-            board[x][y] = new Rook(isWhite);
-            break;
-        case 'B': case 'b':
-            board[x][y] = new Bishop(isWhite);
-            break;
-        case 'N': case 'n':
-            board[x][y] = new Knight(isWhite);
-            break;
-        default:
-            board[x][y] = new Queen(isWhite); // Default to queen
+    PieceType type = pieceTypeFromSymbol(pieceType);
+    if (type != ROOK && type != BISHOP && type != KNIGHT) {
+        type = QUEEN; // Queen, also the default
     }
+    putPiece(square, makePieceCode(color, type));
 }
 
 bool Board::isGameOver() const {
@@ -354,33 +425,24 @@ bool Board::canCastle(bool isWhiteKing, bool isKingSide) const {
         return false;
     }
     
-    // Check if king is in check
-    if (isCheck(isWhiteKing)) {
-        return false;
-    }
-    
-    // Check if squares between king and rook are empty
+    // Rook must still be on its corner
     int kingX = isWhiteKing ? 7 : 0;
     int kingY = 4;
     int rookY = isKingSide ? 7 : 0;
-    
-    int startY = std::min(kingY, rookY) + 1;
-    int endY = std::max(kingY, rookY);
-    
-    for (int y = startY; y < endY; ++y) {
-        if (board[kingX][y] != nullptr) {
-            return false;
-        }
+    if (!(getPieces(isWhiteKing, ROOK) & squareBit(kingX, rookY))) {
+        return false;
     }
     
-    // Check if king doesn't move through check
-    int kingDestY = isKingSide ? 6 : 2;
-    if (isSquareUnderAttack(kingX, kingY, !isWhiteKing) ||
-        isSquareUnderAttack(kingX, kingDestY, !isWhiteKing)) {
+    // Squares between king and rook must be empty
+    if (betweenSquares(squareIndex(kingX, kingY), squareIndex(kingX, rookY)) & getOccupancy()) {
         return false;
     }
     
-    return true;
+    // King may not castle out of, through or into check
+    int kingDestY = isKingSide ? 6 : 2;
+    Bitboard kingPath = squareBit(kingX, kingY) | squareBit(kingX, (kingY + kingDestY) / 2) |
+                        squareBit(kingX, kingDestY);
+    return (kingPath & getAttackedSquares(!isWhiteKing)) == 0;
 }
 
 bool Board::performCastling(bool isWhiteKing, bool isKingSide) {
@@ -391,16 +453,19 @@ bool Board::performCastling(bool isWhiteKing, bool isKingSide) {
     int kingX = isWhiteKing ? 7 : 0;
     int kingY = 4;
     int rookY = isKingSide ? 7 : 0;
+    invalidateAttackMaps();
     
     // Move king
     int kingDestY = isKingSide ? 6 : 2;
-    board[kingX][kingDestY] = board[kingX][kingY];
-    board[kingX][kingY] = nullptr;
+    PieceCode king = squares[squareIndex(kingX, kingY)];
+    removePiece(squareIndex(kingX, kingY));
+    putPiece(squareIndex(kingX, kingDestY), king);
     
     // Move rook
     int rookDestY = isKingSide ? 5 : 3;
-    board[kingX][rookDestY] = board[kingX][rookY];
-    board[kingX][rookY] = nullptr;
+    PieceCode rook = squares[squareIndex(kingX, rookY)];
+    removePiece(squareIndex(kingX, rookY));
+    putPiece(squareIndex(kingX, rookDestY), rook);
     
     // Record movements
     recordPieceMovement(kingX, kingY);
@@ -410,15 +475,14 @@ bool Board::performCastling(bool isWhiteKing, bool isKingSide) {
 }
 
 bool Board::hasKingMoved(bool isWhiteKing) const {
-    int kingX = isWhiteKing ? 7 : 0;
-    int kingY = 4;
-    return movedPieces.find({kingX, kingY}) != movedPieces.end();
+    int rights = isWhiteKing ? (WHITE_KINGSIDE | WHITE_QUEENSIDE) : (BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    return (castlingRights & rights) == 0;
 }
 
 bool Board::hasRookMoved(bool isWhiteKing, bool isKingSide) const {
-    int rookX = isWhiteKing ? 7 : 0;
-    int rookY = isKingSide ? 7 : 0;
-    return movedPieces.find({rookX, rookY}) != movedPieces.end();
+    int right = isWhiteKing ? (isKingSide ? WHITE_KINGSIDE : WHITE_QUEENSIDE)
+                            : (isKingSide ? BLACK_KINGSIDE : BLACK_QUEENSIDE);
+    return (castlingRights & right) == 0;
 }
 
 // En Passant methods
@@ -433,13 +497,10 @@ bool Board::canEnPassant(int x1, int y1, int x2, int y2) const {
     }
     
     // Check if there's an opponent pawn on the same rank
-    Piece* adjacentPawn = board[x1][y2];
-    if (!adjacentPawn || adjacentPawn->getSymbol() != (board[x1][y1]->isWhite() ? 'p' : 'P') ||
-        adjacentPawn->isWhite() == board[x1][y1]->isWhite()) {
-        return false;
-    }
-    
-    return true;
+    PieceCode moving = squares[squareIndex(x1, y1)];
+    if (!moving) return false;
+    int them = pieceCodeColor(moving) == WHITE ? BLACK : WHITE;
+    return squares[squareIndex(x1, y2)] == makePieceCode(them, PAWN);
 }
 
 bool Board::performEnPassant(int x1, int y1, int x2, int y2) {
@@ -447,13 +508,15 @@ bool Board::performEnPassant(int x1, int y1, int x2, int y2) {
         return false;
     }
     
+    invalidateAttackMaps();
+    
     // Move the pawn
-    board[x2][y2] = board[x1][y1];
-    board[x1][y1] = nullptr;
+    PieceCode pawn = squares[squareIndex(x1, y1)];
+    removePiece(squareIndex(x1, y1));
+    putPiece(squareIndex(x2, y2), pawn);
     
     // Remove the captured pawn
-    delete board[x1][y2];
-    board[x1][y2] = nullptr;
+    removePiece(squareIndex(x1, y2));
     
     // Clear en passant target
     clearEnPassantTarget();
@@ -462,7 +525,9 @@ bool Board::performEnPassant(int x1, int y1, int x2, int y2) {
 }
 
 void Board::setEnPassantTarget(int x, int y) {
+    clearEnPassantTarget();
     enPassantTarget = {x, y};
+    zobristKey ^= zobristEnPassantKey(y);
 }
 
 std::pair<int, int> Board::getEnPassantTarget() const {
@@ -470,40 +535,357 @@ std::pair<int, int> Board::getEnPassantTarget() const {
 }
 
 void Board::clearEnPassantTarget() {
+    if (enPassantTarget.first != -1) {
+        zobristKey ^= zobristEnPassantKey(enPassantTarget.second);
+    }
     enPassantTarget = {-1, -1};
 }
 
 void Board::recordPieceMovement(int x, int y) {
-    movedPieces.insert({x, y});
+    int lost = 0;
+    if (x == 7 && y == 4) lost = WHITE_KINGSIDE | WHITE_QUEENSIDE;
+    else if (x == 7 && y == 7) lost = WHITE_KINGSIDE;
+    else if (x == 7 && y == 0) lost = WHITE_QUEENSIDE;
+    else if (x == 0 && y == 4) lost = BLACK_KINGSIDE | BLACK_QUEENSIDE;
+    else if (x == 0 && y == 7) lost = BLACK_KINGSIDE;
+    else if (x == 0 && y == 0) lost = BLACK_QUEENSIDE;
+    
+    if (castlingRights & lost) {
+        zobristKey ^= zobristCastlingKey(castlingRights);
+        castlingRights &= ~lost;
+        zobristKey ^= zobristCastlingKey(castlingRights);
+    }
 }
 
 int Board::evaluatePosition() const {
+    TRACE_SCOPE("eval");
+    // Material plus piece-square bonuses, linear in the piece counts so tools/tune.cpp can fit it
+    const EvalParams& params = getEvalParams();
+    
     int score = 0;
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        Bitboard white = pieceBitboards[WHITE][t];
+        Bitboard black = pieceBitboards[BLACK][t];
+        score += params.pieceValues[t] * (popCount(white) - popCount(black));
+        while (white) score += params.pieceSquare[t][popLowestSquare(white)];
+        while (black) score -= params.pieceSquare[t][relativeSquare(BLACK, popLowestSquare(black))];
+    }
+    return score;
+}
+
+
+// Attack maps
+Bitboard Board::computeSideAttacks(int color, Bitboard occupied, Bitboard* byType) const {
+    Bitboard all = 0;
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        Bitboard pieces = pieceBitboards[color][t];
+        Bitboard attacks = 0;
+        while (pieces) {
+            int square = popLowestSquare(pieces);
+            switch (t) {
+                case PAWN:   attacks |= pawnAttacks(color == WHITE, square); break;
+                case KNIGHT: attacks |= knightAttacks(square); break;
+                case BISHOP: attacks |= bishopAttacks(square, occupied); break;
+                case ROOK:   attacks |= rookAttacks(square, occupied); break;
+                case QUEEN:  attacks |= queenAttacks(square, occupied); break;
+                case KING:   attacks |= kingAttacks(square); break;
+            }
+        }
+        if (byType) byType[t] = attacks;
+        all |= attacks;
+    }
+    return all;
+}
+
+void Board::computeAttackMaps() const {
+    Bitboard occupied = colorOccupancy[WHITE] | colorOccupancy[BLACK];
+    for (int c = 0; c < COLOR_COUNT; ++c) {
+        attackedBy[c] = computeSideAttacks(c, occupied, attackedByType[c]);
+    }
     
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            Piece* piece = board[i][j];
-            if (piece) {
-                int value = 0;
-                char symbol = piece->getSymbol();
-                
-                switch (toupper(symbol)) {
-                    case 'P': value = 1; break;   // Pawn
-                    case 'N': value = 3; break;   // Knight
-                    case 'B': value = 3; break;   // Bishop
-                    case 'R': value = 5; break;   // Rook
-                    case 'Q': value = 9; break;   // Queen
-                    case 'K': value = 100; break; // King
-                }
-                
-                if (piece->isWhite()) {
-                    score += value;
-                } else {
-                    score -= value;
-                }
+    attackMapsValid = true;
+}
+
+void Board::computeCheckInfo(int color) const {
+    int them = color == WHITE ? BLACK : WHITE;
+    Bitboard occupied = colorOccupancy[WHITE] | colorOccupancy[BLACK];
+    Bitboard king = pieceBitboards[color][KING];
+    
+    checkers[color] = 0;
+    pinned[color] = 0;
+    checkMask[color] = ~0ULL;
+    kingDanger[color] = 0;
+    
+    if (king) {
+        int kingSquare = lowestSquare(king);
+        checkers[color] = getAttackersTo(kingSquare / 8, kingSquare % 8, them == WHITE);
+        
+        // Enemy sliders lined up with the king pin the single own piece between them
+        Bitboard diagonal = pieceBitboards[them][BISHOP] | pieceBitboards[them][QUEEN];
+        Bitboard straight = pieceBitboards[them][ROOK] | pieceBitboards[them][QUEEN];
+        Bitboard snipers = (bishopAttacks(kingSquare, 0) & diagonal) | (rookAttacks(kingSquare, 0) & straight);
+        while (snipers) {
+            int sniper = popLowestSquare(snipers);
+            Bitboard blockers = betweenSquares(kingSquare, sniper) & occupied;
+            if (blockers && !(blockers & (blockers - 1)) && (blockers & colorOccupancy[color])) {
+                pinned[color] |= blockers;
             }
         }
+        
+        if (checkers[color]) {
+            if (popCount(checkers[color]) > 1) {
+                checkMask[color] = 0;
+            } else {
+                int checker = lowestSquare(checkers[color]);
+                checkMask[color] = betweenSquares(kingSquare, checker) | squareBit(checker);
+            }
+        }
+        
+        // The king must not hide behind itself from a slider
+        kingDanger[color] = computeSideAttacks(them, occupied & ~king, nullptr);
+    }
+    
+    checkInfoValid[color] = true;
+}
+
+Bitboard Board::legalTargets(int square) const {
+    PieceCode code = squares[square];
+    if (!code) return 0;
+    int us = pieceCodeColor(code);
+    if (!checkInfoValid[us]) computeCheckInfo(us);
+    
+    switch (code) {
+        case makePieceCode(WHITE, PAWN):   return legalTargets<PAWN, WHITE>(square);
+        case makePieceCode(WHITE, KNIGHT): return legalTargets<KNIGHT, WHITE>(square);
+        case makePieceCode(WHITE, BISHOP): return legalTargets<BISHOP, WHITE>(square);
+        case makePieceCode(WHITE, ROOK):   return legalTargets<ROOK, WHITE>(square);
+        case makePieceCode(WHITE, QUEEN):  return legalTargets<QUEEN, WHITE>(square);
+        case makePieceCode(WHITE, KING):   return legalTargets<KING, WHITE>(square);
+        case makePieceCode(BLACK, PAWN):   return legalTargets<PAWN, BLACK>(square);
+        case makePieceCode(BLACK, KNIGHT): return legalTargets<KNIGHT, BLACK>(square);
+        case makePieceCode(BLACK, BISHOP): return legalTargets<BISHOP, BLACK>(square);
+        case makePieceCode(BLACK, ROOK):   return legalTargets<ROOK, BLACK>(square);
+        case makePieceCode(BLACK, QUEEN):  return legalTargets<QUEEN, BLACK>(square);
+        case makePieceCode(BLACK, KING):   return legalTargets<KING, BLACK>(square);
+        default: return 0;
+    }
+}
+
+template <PieceType Type, Color Us>
+Bitboard Board::legalTargets(int square) const {
+    const Color Them = Us == WHITE ? BLACK : WHITE;
+    Bitboard from = squareBit(square);
+    Bitboard own = colorOccupancy[Us];
+    Bitboard enemy = colorOccupancy[Them];
+    Bitboard occupied = own | enemy;
+    
+    if (Type == KING) {
+        Bitboard targets = kingAttacks(square) & ~own & ~kingDanger[Us];
+        
+        // Castling is encoded as a two-square king move
+        const int kingX = Us == WHITE ? 7 : 0;
+        if (square == squareIndex(kingX, 4) && !checkers[Us]) {
+            if (canCastle(Us == WHITE, true)) targets |= squareBit(kingX, 6);
+            if (canCastle(Us == WHITE, false)) targets |= squareBit(kingX, 2);
+        }
+        return targets;
     }
     
-    return score;
+    if (!checkMask[Us]) return 0; // Double check
+    
+    Bitboard targets = 0;
+    Bitboard enPassant = 0;
+    switch (Type) {
+        case PAWN: {
+            const int forward = Us == WHITE ? -8 : 8;
+            const int startRow = Us == WHITE ? 6 : 1;
+            const int lastRow = Us == WHITE ? 0 : 7;
+            Bitboard push = square / 8 != lastRow ? squareBit(square + forward) & ~occupied : 0;
+            targets = push;
+            if (push && square / 8 == startRow) {
+                targets |= squareBit(square + 2 * forward) & ~occupied;
+            }
+            targets |= pawnAttacks(Us == WHITE, square) & enemy;
+            
+            if (enPassantTarget.first != -1 &&
+                (pawnAttacks(Us == WHITE, square) & squareBit(enPassantTarget.first, enPassantTarget.second)) &&
+                canEnPassant(square / 8, square % 8, enPassantTarget.first, enPassantTarget.second)) {
+                enPassant = squareBit(enPassantTarget.first, enPassantTarget.second);
+            }
+            break;
+        }
+        case KNIGHT: targets = knightAttacks(square) & ~own; break;
+        case BISHOP: targets = bishopAttacks(square, occupied) & ~own; break;
+        case ROOK:   targets = rookAttacks(square, occupied) & ~own; break;
+        case QUEEN:  targets = queenAttacks(square, occupied) & ~own; break;
+        default: break;
+    }
+    
+    targets &= checkMask[Us];
+    
+    Bitboard king = pieceBitboards[Us][KING];
+    if (king && (pinned[Us] & from)) {
+        targets &= lineThrough(lowestSquare(king), square);
+    }
+    
+    // En passant removes two pieces from the capturing rank; verify the king directly
+    if (enPassant && king) {
+        int kingSquare = lowestSquare(king);
+        Bitboard captured = squareBit(square / 8, enPassantTarget.second);
+        Bitboard after = (occupied & ~from & ~captured) | enPassant;
+        Bitboard diagonal = pieceBitboards[Them][BISHOP] | pieceBitboards[Them][QUEEN];
+        Bitboard straight = pieceBitboards[Them][ROOK] | pieceBitboards[Them][QUEEN];
+        Bitboard attackers = (bishopAttacks(kingSquare, after) & diagonal) |
+                             (rookAttacks(kingSquare, after) & straight) |
+                             (knightAttacks(kingSquare) & pieceBitboards[Them][KNIGHT]) |
+                             (pawnAttacks(Us == WHITE, kingSquare) & pieceBitboards[Them][PAWN] & ~captured);
+        if (!attackers) {
+            targets |= enPassant;
+        }
+    } else {
+        targets |= enPassant;
+    }
+    
+    return targets;
+}
+
+template <PieceType Type, Color Us>
+void Board::generate(std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& moves) const {
+    Bitboard pieces = pieceBitboards[Us][Type];
+    while (pieces) {
+        int from = popLowestSquare(pieces);
+        Bitboard targets = legalTargets<Type, Us>(from);
+        while (targets) {
+            int to = popLowestSquare(targets);
+            moves.push_back({{from / 8, from % 8}, {to / 8, to % 8}});
+        }
+    }
+}
+
+template <Color Us>
+void Board::generateAll(std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& moves) const {
+    // Double check: only the king can move
+    if (popCount(checkers[Us]) <= 1) {
+        generate<PAWN, Us>(moves);
+        generate<KNIGHT, Us>(moves);
+        generate<BISHOP, Us>(moves);
+        generate<ROOK, Us>(moves);
+        generate<QUEEN, Us>(moves);
+    }
+    generate<KING, Us>(moves);
+}
+
+template <PieceType Type, Color Us>
+bool Board::canAnyMove() const {
+    Bitboard pieces = pieceBitboards[Us][Type];
+    while (pieces) {
+        if (legalTargets<Type, Us>(popLowestSquare(pieces))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <Color Us>
+bool Board::hasAnyLegalMove() const {
+    // King first: it is the only piece that can answer a double check
+    if (canAnyMove<KING, Us>()) return true;
+    if (popCount(checkers[Us]) > 1) return false;
+    return canAnyMove<PAWN, Us>() || canAnyMove<KNIGHT, Us>() || canAnyMove<BISHOP, Us>() ||
+           canAnyMove<ROOK, Us>() || canAnyMove<QUEEN, Us>();
+}
+
+Bitboard Board::getAttackedSquares(bool byWhite) const {
+    if (!attackMapsValid) computeAttackMaps();
+    return attackedBy[colorIndex(byWhite)];
+}
+
+Bitboard Board::getAttacksByPieceType(bool byWhite, PieceType type) const {
+    if (!attackMapsValid) computeAttackMaps();
+    return attackedByType[colorIndex(byWhite)][type];
+}
+
+// Pieces of one side attacking a square, found by looking outwards from the square
+Bitboard Board::getAttackersTo(int x, int y, bool byWhite) const {
+    int square = squareIndex(x, y);
+    const Bitboard* pieces = pieceBitboards[colorIndex(byWhite)];
+    Bitboard occupied = colorOccupancy[WHITE] | colorOccupancy[BLACK];
+    Bitboard diagonal = pieces[BISHOP] | pieces[QUEEN];
+    Bitboard straight = pieces[ROOK] | pieces[QUEEN];
+    
+    return (pawnAttacks(!byWhite, square) & pieces[PAWN]) |
+           (knightAttacks(square) & pieces[KNIGHT]) |
+           (kingAttacks(square) & pieces[KING]) |
+           (diagonal ? bishopAttacks(square, occupied) & diagonal : 0) |
+           (straight ? rookAttacks(square, occupied) & straight : 0);
+}
+
+Bitboard Board::getPieces(bool isWhite, PieceType type) const {
+    return pieceBitboards[colorIndex(isWhite)][type];
+}
+
+Bitboard Board::getOccupancy() const {
+    return colorOccupancy[WHITE] | colorOccupancy[BLACK];
+}
+
+Bitboard Board::getCheckers(bool isWhiteKing) const {
+    int color = colorIndex(isWhiteKing);
+    if (!checkInfoValid[color]) computeCheckInfo(color);
+    return checkers[color];
+}
+
+Bitboard Board::getPinnedPieces(bool isWhite) const {
+    int color = colorIndex(isWhite);
+    if (!checkInfoValid[color]) computeCheckInfo(color);
+    return pinned[color];
+}
+
+// Position state for hashing and draw rules
+bool Board::isWhiteToMove() const {
+    return whiteToMove;
+}
+
+int Board::getHalfmoveClock() const {
+    return halfmoveClock;
+}
+
+int Board::getCastlingRights() const {
+    return castlingRights;
+}
+
+uint64_t Board::getZobristKey() const {
+    return zobristKey;
+}
+
+uint64_t Board::computeZobristKey() const {
+    uint64_t key = 0;
+    for (int square = 0; square < 64; ++square) {
+        PieceCode code = squares[square];
+        if (code) {
+            key ^= zobristPieceKey(pieceCodeColor(code), pieceCodeType(code), square);
+        }
+    }
+    key ^= zobristCastlingKey(castlingRights);
+    if (enPassantTarget.first != -1) key ^= zobristEnPassantKey(enPassantTarget.second);
+    if (!whiteToMove) key ^= zobristSideKey();
+    return key;
+}
+
+bool Board::isInsufficientMaterial() const {
+    const Bitboard* white = pieceBitboards[WHITE];
+    const Bitboard* black = pieceBitboards[BLACK];
+    if (white[PAWN] | black[PAWN] | white[ROOK] | black[ROOK] | white[QUEEN] | black[QUEEN]) {
+        return false;
+    }
+    
+    // K vs K, or a single minor piece
+    Bitboard knights = white[KNIGHT] | black[KNIGHT];
+    Bitboard bishops = white[BISHOP] | black[BISHOP];
+    if (popCount(knights | bishops) <= 1) {
+        return true;
+    }
+    
+    // Only bishops, all on squares of one colour
+    const Bitboard LIGHT_SQUARES = 0xAA55AA55AA55AA55ULL;
+    return !knights && (!(bishops & LIGHT_SQUARES) || !(bishops & ~LIGHT_SQUARES));
 }
@@ -0,0 +1,92 @@
+#include "../include/EPD.h"
+#include <cctype>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+bool isNumber(const std::string& text) {
+    if (text.empty()) return false;
+    for (char c : text) {
+        if (!isdigit(static_cast<unsigned char>(c))) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string EPDRecord::operation(const std::string& opcode) const {
+    for (const auto& entry : operations) {
+        if (entry.first == opcode) return entry.second;
+    }
+    return "";
+}
+
+std::string EPDRecord::toFEN() const {
+    std::string halfmove = operation("hmvc");
+    std::string fullmove = operation("fmvn");
+    return position + " " + (halfmove.empty() ? "0" : halfmove) + " " + (fullmove.empty() ? "1" : fullmove);
+}
+
+bool parseEPD(const std::string& line, EPDRecord& record) {
+    record = EPDRecord();
+    std::string text = trim(line);
+    if (text.empty() || text[0] == '#') {
+        return false;
+    }
+    
+    std::istringstream iss(text);
+    std::string fields[4];
+    for (auto& field : fields) {
+        if (!(iss >> field)) return false;
+    }
+    record.position = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+    
+    std::string rest;
+    std::getline(iss, rest);
+    rest = trim(rest);
+    
+    // FEN clocks instead of operations
+    std::istringstream clocks(rest);
+    std::string halfmove, fullmove, extra;
+    if (clocks >> halfmove >> fullmove && !(clocks >> extra) && isNumber(halfmove) && isNumber(fullmove)) {
+        record.operations.push_back({"hmvc", halfmove});
+        record.operations.push_back({"fmvn", fullmove});
+        return true;
+    }
+    
+    // Operations are separated by ';', which may also appear inside quoted operands
+    std::string operation;
+    bool quoted = false;
+    for (size_t i = 0; i <= rest.length(); ++i) {
+        char c = i < rest.length() ? rest[i] : ';';
+        if (c == '"') quoted = !quoted;
+        if (c != ';' || quoted) {
+            operation += c;
+            continue;
+        }
+        
+        operation = trim(operation);
+        if (!operation.empty()) {
+            size_t space = operation.find_first_of(" \t");
+            std::string opcode = operation.substr(0, space);
+            std::string operand = space == std::string::npos ? "" : trim(operation.substr(space));
+            record.operations.push_back({opcode, operand});
+        }
+        operation.clear();
+    }
+    return true;
+}
+
+std::string unquote(const std::string& operand) {
+    if (operand.length() >= 2 && operand.front() == '"' && operand.back() == '"') {
+        return operand.substr(1, operand.length() - 2);
+    }
+    return operand;
+}
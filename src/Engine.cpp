@@ -0,0 +1,37 @@
+#include "../include/Engine.h"
+#include <thread>
+
+SearchHandle::Shared::~Shared() {
+    stopRequested.store(true);
+    if (result.valid()) {
+        result.wait(); // The search thread still reads stopRequested
+    }
+}
+
+void SearchHandle::stop() {
+    if (shared) {
+        shared->stopRequested.store(true);
+    }
+}
+
+bool SearchHandle::isFinished() const {
+    return shared && shared->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+const SearchResult& SearchHandle::wait() const {
+    return shared->result.get();
+}
+
+SearchHandle Engine::search(const Game& position, SearchLimits limits, ProgressCallback onProgress) {
+    SearchHandle handle;
+    handle.shared = std::make_shared<SearchHandle::Shared>();
+    limits.stop = &handle.shared->stopRequested;
+    
+    // The thread owns its copy of the position; the shared state outlives it (see ~Shared)
+    std::packaged_task<SearchResult()> task([position, limits, onProgress] {
+        return position.search(limits, onProgress);
+    });
+    handle.shared->result = task.get_future().share();
+    std::thread(std::move(task)).detach();
+    return handle;
+}
@@ -0,0 +1,134 @@
+#include "../include/Evaluation.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Kings are always on the board, so their value only matters for positions set up without one
+const int DEFAULT_PIECE_VALUES[PIECE_TYPE_COUNT] = { 100, 300, 300, 500, 900, 10000 };
+const char* const DEFAULT_EVAL_FILE = "eval.params";
+const char* const PIECE_LETTERS = "PNBRQK";
+
+EvalParams currentParams;
+
+} // namespace
+
+EvalParams::EvalParams() {
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        pieceValues[t] = DEFAULT_PIECE_VALUES[t];
+        for (int square = 0; square < 64; ++square) {
+            pieceSquare[t][square] = 0;
+        }
+    }
+}
+
+const EvalParams& getEvalParams() {
+    return currentParams;
+}
+
+void setEvalParams(const EvalParams& params) {
+    currentParams = params;
+}
+
+// FNV-1a over the values in declaration order
+uint64_t evalParamsHash(const EvalParams& params) {
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](int value) {
+        uint32_t bits = static_cast<uint32_t>(value);
+        for (int i = 0; i < 4; ++i) {
+            hash = (hash ^ (bits >> (8 * i) & 0xFF)) * 1099511628211ull;
+        }
+    };
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        add(params.pieceValues[t]);
+        for (int square = 0; square < 64; ++square) {
+            add(params.pieceSquare[t][square]);
+        }
+    }
+    return hash;
+}
+
+bool loadEvalParams(const std::string& filename, EvalParams& params) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for reading.\n";
+        return false;
+    }
+    
+    EvalParams loaded;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string keyword, piece;
+        if (!(fields >> keyword)) {
+            continue;
+        }
+        PieceType type = PIECE_TYPE_COUNT;
+        if (fields >> piece && piece.size() == 1) {
+            type = pieceTypeFromSymbol(piece[0]);
+        }
+        
+        bool ok = type != PIECE_TYPE_COUNT;
+        if (ok && keyword == "value") {
+            ok = static_cast<bool>(fields >> loaded.pieceValues[type]);
+        } else if (ok && keyword == "pst") {
+            // The 64 values may span several lines
+            for (int square = 0; square < 64 && ok; ++square) {
+                while (ok && !(fields >> loaded.pieceSquare[type][square])) {
+                    ok = fields.eof() && std::getline(in, line);
+                    lineNumber++;
+                    fields.clear();
+                    fields.str(line.substr(0, line.find('#')));
+                }
+            }
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Error: Invalid evaluation parameter at " << filename << ":" << lineNumber << ".\n";
+            return false;
+        }
+    }
+    params = loaded;
+    return true;
+}
+
+bool saveEvalParams(const std::string& filename, const EvalParams& params) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for writing.\n";
+        return false;
+    }
+    
+    out << "# Evaluation parameters in centipawns, White's point of view\n";
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        out << "value " << PIECE_LETTERS[t] << " " << params.pieceValues[t] << "\n";
+    }
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        out << "pst " << PIECE_LETTERS[t] << "\n";
+        for (int square = 0; square < 64; ++square) {
+            out << (square % 8 ? " " : "") << params.pieceSquare[t][square] << (square % 8 == 7 ? "\n" : "");
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool loadStartupEvalParams() {
+    const char* configured = std::getenv("CHESS_EVAL_FILE");
+    bool explicitFile = configured && *configured;
+    std::string filename = explicitFile ? configured : DEFAULT_EVAL_FILE;
+    if (!explicitFile && !std::ifstream(filename).is_open()) {
+        return true; // No parameter file; the defaults apply
+    }
+    
+    EvalParams params;
+    if (!loadEvalParams(filename, params)) {
+        return false;
+    }
+    setEvalParams(params);
+    return true;
+}
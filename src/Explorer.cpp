@@ -0,0 +1,186 @@
+#include "../include/Explorer.h"
+#include "../include/Zobrist.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(ExplorerHeader) == 40, "ExplorerHeader is part of the file format");
+static_assert(sizeof(ExplorerPosition) == 16, "ExplorerPosition is part of the file format");
+static_assert(sizeof(ExplorerMoveRecord) == 32, "ExplorerMoveRecord is part of the file format");
+
+namespace {
+
+bool moreGames(const ExplorerMoveRecord& a, const ExplorerMoveRecord& b) {
+    return a.games != b.games ? a.games > b.games : a.move < b.move;
+}
+
+} // namespace
+
+void ExplorerMoveRecord::add(const ExplorerMoveRecord& other) {
+    games += other.games;
+    wins += other.wins;
+    draws += other.draws;
+    losses += other.losses;
+    ratedGames += other.ratedGames;
+    ratingSum += other.ratingSum;
+}
+
+uint64_t explorerKey(const Board& board) {
+    uint64_t key = board.getZobristKey();
+    std::pair<int, int> target = board.getEnPassantTarget();
+    if (target.first == -1) {
+        return key;
+    }
+    
+    // The capturing pawns stand beside the target square, on the row the pushed pawn reached
+    bool white = board.isWhiteToMove();
+    int row = target.first + (white ? 1 : -1);
+    PieceCode pawn = makePieceCode(colorIndex(white), PAWN);
+    for (int column = target.second - 1; column <= target.second + 1; column += 2) {
+        if (column >= 0 && column < 8 && board.getPieceCode(row, column) == pawn) {
+            return key;
+        }
+    }
+    return key ^ zobristEnPassantKey(target.second);
+}
+
+uint16_t explorerMoveCode(const std::pair<std::pair<int, int>, std::pair<int, int>>& move) {
+    int from = squareIndex(move.first.first, move.first.second);
+    int to = squareIndex(move.second.first, move.second.second);
+    return static_cast<uint16_t>(from << 6 | to);
+}
+
+std::pair<std::pair<int, int>, std::pair<int, int>> explorerMoveFromCode(uint16_t code) {
+    int from = code >> 6 & 63;
+    int to = code & 63;
+    return {{from / 8, from % 8}, {to / 8, to % 8}};
+}
+
+double ExplorerMove::score() const {
+    return games ? (wins + 0.5 * draws) / games : 0;
+}
+
+ExplorerIndex::ExplorerIndex() : header(nullptr), moveRecords(nullptr), positions(nullptr) {}
+
+bool ExplorerIndex::open(const std::string& filename) {
+    close();
+    // Queries jump around the position table
+    if (!file.open(filename, true)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    header = reinterpret_cast<const ExplorerHeader*>(data);
+    bool valid = size >= sizeof(ExplorerHeader) &&
+                 std::memcmp(header->magic, EXPLORER_MAGIC, sizeof(EXPLORER_MAGIC)) == 0 &&
+                 header->version == EXPLORER_VERSION &&
+                 size == sizeof(ExplorerHeader) + header->moveCount * sizeof(ExplorerMoveRecord) +
+                         header->positionCount * sizeof(ExplorerPosition);
+    if (!valid) {
+        std::cerr << "Error: " << filename << " is not an explorer index.\n";
+        close();
+        return false;
+    }
+    moveRecords = reinterpret_cast<const ExplorerMoveRecord*>(data + sizeof(ExplorerHeader));
+    positions = reinterpret_cast<const ExplorerPosition*>(moveRecords + header->moveCount);
+    return true;
+}
+
+void ExplorerIndex::close() {
+    file.close();
+    header = nullptr;
+    moveRecords = nullptr;
+    positions = nullptr;
+}
+
+void ExplorerIndex::query(uint64_t key, std::vector<ExplorerMove>& moves) const {
+    moves.clear();
+    if (!isOpen()) {
+        return;
+    }
+    
+    const ExplorerPosition* end = positions + header->positionCount;
+    const ExplorerPosition* found = std::lower_bound(positions, end, key,
+        [](const ExplorerPosition& position, uint64_t value) { return position.key < value; });
+    if (found == end || found->key != key) {
+        return;
+    }
+    
+    for (uint32_t i = 0; i < found->moveCount; ++i) {
+        const ExplorerMoveRecord& record = moveRecords[found->firstMove + i];
+        ExplorerMove move;
+        move.move = explorerMoveFromCode(record.move);
+        move.games = record.games;
+        move.wins = record.wins;
+        move.draws = record.draws;
+        move.losses = record.losses;
+        move.averageRating = record.ratedGames ? static_cast<double>(record.ratingSum) / record.ratedGames : 0;
+        moves.push_back(move);
+    }
+}
+
+void ExplorerIndex::query(const Board& board, std::vector<ExplorerMove>& moves) const {
+    query(explorerKey(board), moves);
+}
+
+bool ExplorerIndex::query(const std::string& fen, std::vector<ExplorerMove>& moves) const {
+    Board board;
+    if (!board.loadFEN(fen)) {
+        moves.clear();
+        return false;
+    }
+    query(board, moves);
+    return true;
+}
+
+bool ExplorerIndexWriter::open(const std::string& filename, uint32_t maxPlies) {
+    this->filename = filename;
+    out.open(filename, std::ios::binary | std::ios::trunc);
+    positionsOut.open(filename + ".positions", std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !positionsOut.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for writing.\n";
+        return false;
+    }
+    
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, EXPLORER_MAGIC, sizeof(EXPLORER_MAGIC));
+    header.version = EXPLORER_VERSION;
+    header.maxPlies = maxPlies;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Rewritten by finish()
+    return true;
+}
+
+void ExplorerIndexWriter::add(uint64_t key, std::vector<ExplorerMoveRecord>& moves) {
+    std::sort(moves.begin(), moves.end(), moreGames);
+    ExplorerPosition position;
+    position.key = key;
+    position.firstMove = static_cast<uint32_t>(header.moveCount);
+    position.moveCount = static_cast<uint32_t>(moves.size());
+    positionsOut.write(reinterpret_cast<const char*>(&position), sizeof(position));
+    out.write(reinterpret_cast<const char*>(moves.data()), moves.size() * sizeof(ExplorerMoveRecord));
+    header.positionCount++;
+    header.moveCount += moves.size();
+}
+
+bool ExplorerIndexWriter::finish(uint64_t games) {
+    header.games = games;
+    positionsOut.close();
+    
+    std::string positionsFile = filename + ".positions";
+    if (header.positionCount > 0) {
+        std::ifstream positionsIn(positionsFile, std::ios::binary);
+        out << positionsIn.rdbuf();
+    }
+    std::remove(positionsFile.c_str());
+    
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write " << filename << ".\n";
+        return false;
+    }
+    return true;
+}
@@ -1,13 +1,30 @@
 #include "../include/Game.h"
+#include "../include/AnalysisCache.h"
+#include "../include/Evaluation.h"
+#include "../include/Trace.h"
+#include "../include/TranspositionTable.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <random>
 #include <chrono>
 #include <fstream> // Required for save/load/export/import
+#include <cstdlib>
 
-Game::Game() : board(), currentPlayer(true), moveCount(0), 
-               aiEnabled(false), aiDifficulty(AIDifficulty::RANDOM), aiPlaysAsWhite(false) {}
+// Search window bounds, beyond any mate score
+static const int SCORE_INFINITY = 10 * MATE_SCORE;
+// Root score before any move has been searched; outside the search window
+static const int NO_SCORE = -100 * MATE_SCORE;
+
+static const char* const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Plies between stored boards of the game's line, the most moves replayed to reach any ply
+static const size_t HISTORY_CHECKPOINT_PLIES = 16;
+
+Game::Game() : board(), currentPlayer(true), moveCount(0), startFEN(START_FEN),
+               aiEnabled(false), aiDifficulty(AIDifficulty::RANDOM), aiPlaysAsWhite(false) {
+    resetHistory();
+}
 
 void Game::setAIOpponent(bool enabled, AIDifficulty difficulty) {
     aiEnabled = enabled;
@@ -161,12 +178,8 @@ bool Game::makeMove(int x1, int y1, int x2, int y2) {
         return false;
     }
     
-    // Make the move
-    board.movePiece(x1, y1, x2, y2);
-    
-    // Record the move
-    Move move(x1, y1, x2, y2);
-    moveHistory.push_back(move);
+    // Make and record the move
+    recordMove(x1, y1, x2, y2);
     
     // Convert coordinates to chess notation for display
     std::string from = getChessNotation(x1, y1);
@@ -175,6 +188,107 @@ bool Game::makeMove(int x1, int y1, int x2, int y2) {
     return true;
 }
 
+bool Game::applyMove(int x1, int y1, int x2, int y2) {
+    if (x1 < 0 || x1 >= 8 || y1 < 0 || y1 >= 8 || 
+        x2 < 0 || x2 >= 8 || y2 < 0 || y2 >= 8) {
+        return false;
+    }
+    
+    Piece* piece = board.getPiece(x1, y1);
+    if (!piece || piece->isWhite() != currentPlayer || !board.isValidMove(x1, y1, x2, y2)) {
+        return false;
+    }
+    
+    recordMove(x1, y1, x2, y2);
+    moveCount++;
+    currentPlayer = !currentPlayer;
+    return true;
+}
+
+void Game::recordMove(int x1, int y1, int x2, int y2) {
+    board.movePiece(x1, y1, x2, y2);
+    
+    // Playing the next move of the line keeps the rest of it; any other move replaces it
+    const Move* next = redoMoves.empty() ? nullptr : &redoMoves.back();
+    if (next && next->x1 == x1 && next->y1 == y1 && next->x2 == x2 && next->y2 == y2) {
+        redoMoves.pop_back();
+        redoKeys.pop_back();
+    } else {
+        redoMoves.clear();
+        redoKeys.clear();
+        checkpoints.resize(moveHistory.size() / HISTORY_CHECKPOINT_PLIES + 1);
+    }
+    moveHistory.emplace_back(x1, y1, x2, y2);
+    positionHistory.push_back(board.getZobristKey());
+    if (moveHistory.size() % HISTORY_CHECKPOINT_PLIES == 0 &&
+        checkpoints.size() == moveHistory.size() / HISTORY_CHECKPOINT_PLIES) {
+        checkpoints.push_back(board);
+    }
+}
+
+void Game::resetHistory() {
+    moveHistory.clear();
+    positionHistory.assign(1, board.getZobristKey());
+    redoMoves.clear();
+    redoKeys.clear();
+    checkpoints.assign(1, board);
+}
+
+bool Game::undoMove() {
+    return gotoPly(getPly() - 1);
+}
+
+bool Game::redoMove() {
+    return gotoPly(getPly() + 1);
+}
+
+// Moves and keys shift between the history and the redo line without touching the board, which
+// is then rebuilt from the nearest checkpoint at or before the ply
+bool Game::gotoPly(int ply) {
+    if (ply < 0 || ply > getLastPly()) {
+        return false;
+    }
+    while (getPly() > ply) {
+        redoMoves.push_back(moveHistory.back());
+        redoKeys.push_back(positionHistory.back());
+        moveHistory.pop_back();
+        positionHistory.pop_back();
+        moveCount--;
+        currentPlayer = !currentPlayer;
+    }
+    while (getPly() < ply) {
+        moveHistory.push_back(redoMoves.back());
+        positionHistory.push_back(redoKeys.back());
+        redoMoves.pop_back();
+        redoKeys.pop_back();
+        moveCount++;
+        currentPlayer = !currentPlayer;
+    }
+    
+    size_t checkpoint = ply / HISTORY_CHECKPOINT_PLIES;
+    board = checkpoints[checkpoint];
+    for (size_t i = checkpoint * HISTORY_CHECKPOINT_PLIES; i < moveHistory.size(); ++i) {
+        board.movePiece(moveHistory[i].x1, moveHistory[i].y1, moveHistory[i].x2, moveHistory[i].y2);
+    }
+    return true;
+}
+
+int Game::getPly() const {
+    return static_cast<int>(moveHistory.size());
+}
+
+int Game::getLastPly() const {
+    return static_cast<int>(moveHistory.size() + redoMoves.size());
+}
+
+const Board& Game::getBoard() const {
+    return board;
+}
+
+bool Game::isWhiteToMove() const {
+    return currentPlayer;
+}
+
 std::string Game::getChessNotation(int x, int y) const {
     char file = 'a' + y;
     int rank = 8 - x;
@@ -362,6 +476,72 @@ bool Game::handleSpecialCommands(const std::string& input) {
         return true;
     }
     
+    if (input == "undo" || input == "redo") {
+        bool undo = input == "undo";
+        if (!(undo ? undoMove() : redoMove())) {
+            std::cout << "Nothing to " << input << ".\n";
+            return true;
+        }
+        // Against the AI, step over its move too so that it is the player's turn again
+        if (aiEnabled && currentPlayer == aiPlaysAsWhite) {
+            if (undo) {
+                undoMove();
+            } else {
+                redoMove();
+            }
+        }
+        board.printBoard();
+        std::cout << "Ply " << getPly() << " of " << getLastPly() << ".\n";
+        return true;
+    }
+    
+    if (input.substr(0, 5) == "goto ") {
+        std::istringstream iss(input.substr(5));
+        int ply = -1;
+        if (!(iss >> ply) || !gotoPly(ply)) {
+            std::cout << "Usage: goto <ply>, from 0 to " << getLastPly() << "\n";
+        } else {
+            board.printBoard();
+            std::cout << "Ply " << getPly() << " of " << getLastPly() << ".\n";
+        }
+        return true;
+    }
+    
+    if (input.substr(0, 5) == "trace") {
+        std::istringstream iss(input);
+        std::string cmd, mode, filename;
+        iss >> cmd >> mode >> filename;
+        if (!traceCompiledIn()) {
+            std::cout << "Tracing is not compiled in (configure with -DCHESS_TRACE=ON).\n";
+        } else if (mode == "on" && !filename.empty()) {
+            if (traceStart(filename)) {
+                std::cout << "Tracing to " << filename << "; 'trace off' writes the file.\n";
+            } else {
+                std::cout << "Tracing is already on.\n";
+            }
+        } else if (mode == "off") {
+            if (traceStop()) {
+                std::cout << "Trace written (open it in Perfetto or chrome://tracing).\n";
+            } else {
+                std::cout << "Error: Tracing was not on, or the trace file could not be written.\n";
+            }
+        } else {
+            std::cout << "Usage: trace on <file.json> | trace off\n";
+        }
+        return true;
+    }
+    
+    if (input == "stats") {
+        if (lastSearchStats.depths.empty()) {
+            std::cout << "No minimax search has been run yet.\n";
+        } else {
+            std::cout << "\n=== LAST AI SEARCH ===\n";
+            lastSearchStats.print(std::cout);
+            std::cout << lastSearchStats.toJSON() << "\n";
+        }
+        return true;
+    }
+    
     // Save/Load commands
     if (input.substr(0, 4) == "save") {
         std::istringstream iss(input);
@@ -448,6 +628,10 @@ void Game::displayHelp() const {
     std::cout << "  status, s   - Show game status\n";
     std::cout << "  moves x y   - Show legal moves for piece at (x,y)\n";
     std::cout << "  board, b    - Redisplay the board\n";
+    std::cout << "  undo, redo  - Take back a move, or replay one taken back\n";
+    std::cout << "  goto <ply>  - Go to a ply of the game (0 = start), keeping later moves for redo\n";
+    std::cout << "  stats       - Show statistics of the AI's last search\n";
+    std::cout << "  trace on <file> / trace off - Record a Chrome trace of the search\n";
     std::cout << "  savehelp    - Show save/load commands\n";
     std::cout << "  quit, exit  - Exit the game\n";
     
@@ -472,6 +656,9 @@ void Game::displayMoveHistory() const {
             std::cout << i + 1 << ". " << from << " to " << to << "\n";
         }
     }
+    if (!redoMoves.empty()) {
+        std::cout << redoMoves.size() << " move(s) taken back; 'redo' or 'goto' replays them.\n";
+    }
     std::cout << "\n";
 }
 
@@ -497,16 +684,40 @@ void Game::showLegalMoves(int x, int y) const {
 }
 
 bool Game::isGameEnded() const {
-    return board.isCheckmate(currentPlayer) || board.isStalemate(currentPlayer);
+    return board.isCheckmate(currentPlayer) || board.isStalemate(currentPlayer) || !getDrawReason().empty();
+}
+
+std::string Game::getDrawReason() const {
+    if (board.isInsufficientMaterial()) {
+        return "insufficient material";
+    }
+    if (board.getHalfmoveClock() >= 100) {
+        return "fifty-move rule";
+    }
+    
+    // Threefold repetition, counting only positions since the last capture or pawn move
+    int occurrences = 1;
+    int last = static_cast<int>(positionHistory.size()) - 1;
+    int limit = std::max(0, last - board.getHalfmoveClock());
+    for (int i = last - 2; i >= limit; i -= 2) {
+        if (positionHistory[i] == positionHistory[last] && ++occurrences >= 3) {
+            return "threefold repetition";
+        }
+    }
+    return "";
 }
 
 void Game::announceGameEnd() const {
+    std::string drawReason = getDrawReason();
     if (board.isCheckmate(currentPlayer)) {
         std::cout << "\n🎉 CHECKMATE! 🎉\n";
         std::cout << (currentPlayer ? "Black" : "White") << " wins the game!\n";
     } else if (board.isStalemate(currentPlayer)) {
         std::cout << "\n🤝 STALEMATE! 🤝\n";
         std::cout << "The game is a draw!\n";
+    } else if (!drawReason.empty()) {
+        std::cout << "\n🤝 DRAW! 🤝\n";
+        std::cout << "The game is a draw by " << drawReason << "!\n";
     }
     
     std::cout << "\nGame Statistics:\n";
@@ -527,13 +738,13 @@ void Game::makeAIMove() {
             move = getGreedyMove();
             break;
         case AIDifficulty::MINIMAX_1:
-            move = getMinimaxMove(1);
+            move = minimaxMove(1, lastSearchStats);
             break;
         case AIDifficulty::MINIMAX_2:
-            move = getMinimaxMove(2);
+            move = minimaxMove(2, lastSearchStats);
             break;
         case AIDifficulty::MINIMAX_3:
-            move = getMinimaxMove(3);
+            move = minimaxMove(3, lastSearchStats);
             break;
         default:
             move = getRandomMove();
@@ -574,7 +785,7 @@ std::pair<std::pair<int, int>, std::pair<int, int>> Game::getGreedyMove() const
     }
     
     std::pair<std::pair<int, int>, std::pair<int, int>> bestMove = legalMoves[0];
-    int bestValue = -10000;
+    int bestValue = -SCORE_INFINITY;
     
     for (const auto& move : legalMoves) {
         // Create a temporary board to evaluate the move
@@ -582,8 +793,8 @@ std::pair<std::pair<int, int>, std::pair<int, int>> Game::getGreedyMove() const
         tempBoard.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
         
         int moveValue = tempBoard.evaluatePosition();
-        if (currentPlayer) {
-            moveValue = -moveValue; // AI is playing as current player
+        if (!currentPlayer) {
+            moveValue = -moveValue; // Evaluation is from White's point of view
         }
         
         if (moveValue > bestValue) {
@@ -596,29 +807,292 @@ std::pair<std::pair<int, int>, std::pair<int, int>> Game::getGreedyMove() const
 }
 
 std::pair<std::pair<int, int>, std::pair<int, int>> Game::getMinimaxMove(int depth) const {
+    SearchStats stats;
+    return minimaxMove(depth, stats);
+}
+
+const SearchStats& Game::getLastSearchStats() const {
+    return lastSearchStats;
+}
+
+std::pair<std::pair<int, int>, std::pair<int, int>> Game::minimaxMove(int depth, SearchStats& stats) const {
+    auto start = std::chrono::steady_clock::now();
     auto legalMoves = getAllLegalMoves(currentPlayer);
+    stats = SearchStats();
     
     if (legalMoves.empty()) {
         return {{-1, -1}, {-1, -1}};
     }
     
-    std::pair<std::pair<int, int>, std::pair<int, int>> bestMove = legalMoves[0];
-    int bestValue = -10000;
+    TRACE_SCOPE("depth", depth);
+    SearchState state;
+    state.keyStack = positionHistory;
+    state.keyStack.reserve(state.keyStack.size() + depth + 1);
+    state.nodes = 0;
+    state.nodeLimit = 0;
+    state.hasDeadline = false;
+    state.stopFlag = nullptr;
+    state.stopped = false;
+    state.tt = nullptr;
+    state.initPV(static_cast<int>(positionHistory.size()), depth);
+    
+    std::vector<SearchLine> lines;
+    searchRoot(legalMoves, depth, state, lines, 1);
+    auto bestMove = lines.empty() ? legalMoves[0] : lines[0].move;
+    
+    stats = state.stats;
+    stats.nodes = state.nodes;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.depths.push_back({depth, stats.nodes, stats.seconds});
+    return bestMove;
+}
+
+// Whether a cached result is as good as the search the limits allow: as deep as its depth limit
+// (or the default depth), with as many nodes as its node limit, or a mate. Searches limited only
+// by time are never answered from the cache.
+static bool cacheAnswers(const SearchLimits& limits, int maxDepth, const AnalysisEntry& entry) {
+    if (entry.mateIn != 0) {
+        return true; // The search ends at the first depth that finds a mate
+    }
+    if (limits.depth > 0 || (!limits.nodes && !limits.movetimeMs)) {
+        return entry.depth >= maxDepth;
+    }
+    return limits.nodes > 0 && entry.nodes >= limits.nodes;
+}
+
+// The cache is keyed by the position alone, so it only holds results the game history cannot have
+// changed: no earlier position since the last irreversible move for the search to repeat, and no
+// 50-move draw within the depth searched. historySize counts the position itself.
+static bool cacheableSearch(const Board& board, size_t historySize, int depth) {
+    int clock = board.getHalfmoveClock();
+    return (clock == 0 || historySize <= 1) && clock + depth < 100;
+}
+
+SearchResult Game::search(const SearchLimits& limits,
+                          const std::function<void(const SearchResult&)>& onIteration) const {
+    auto start = std::chrono::steady_clock::now();
+    int maxDepth = limits.depth > 0 ? limits.depth : (limits.nodes || limits.movetimeMs ? 64 : 3);
+    
+    SearchState state;
+    state.keyStack = positionHistory;
+    state.keyStack.reserve(state.keyStack.size() + maxDepth + 1);
+    state.nodes = 0;
+    state.nodeLimit = limits.nodes;
+    state.hasDeadline = limits.movetimeMs > 0;
+    state.deadline = start + std::chrono::milliseconds(limits.movetimeMs);
+    state.stopFlag = limits.stop;
+    state.stopped = false;
+    state.tt = limits.tt;
+    if (state.tt) {
+        state.tt->newSearch();
+    }
+    state.initPV(static_cast<int>(positionHistory.size()), maxDepth);
+    int multiPV = std::max(1, limits.multiPV);
+    
+    SearchResult result;
+    result.bestMove = {{-1, -1}, {-1, -1}};
+    result.mateIn = 0;
+    result.depth = 0;
+    
+    auto legalMoves = getAllLegalMoves(currentPlayer);
+    if (legalMoves.empty()) {
+        result.score = board.isCheck(currentPlayer) ? (currentPlayer ? -MATE_SCORE : MATE_SCORE) : 0;
+    } else {
+        result.bestMove = legalMoves[0];
+        result.score = board.evaluatePosition();
+    }
+    
+    TTEntry rootEntry;
+    if (state.tt && !legalMoves.empty() && state.tt->probe(board.getZobristKey(), rootEntry)) {
+        auto move = std::find(legalMoves.begin(), legalMoves.end(), rootEntry.move);
+        if (move != legalMoves.end()) {
+            std::rotate(legalMoves.begin(), move, move + 1);
+        }
+    }
     
+    AnalysisEntry cached;
+    if (limits.cache && multiPV == 1 && !legalMoves.empty() && limits.cache->probe(board.getZobristKey(), cached)) {
+        auto move = std::find(legalMoves.begin(), legalMoves.end(), cached.move);
+        if (move != legalMoves.end()) {
+            if (!limits.infinite && cacheAnswers(limits, maxDepth, cached) &&
+                cacheableSearch(board, positionHistory.size(), cached.depth)) {
+                result.bestMove = cached.move;
+                result.score = cached.score;
+                result.mateIn = cached.mateIn;
+                result.depth = cached.depth;
+                result.lines.push_back({cached.move, cached.score, cached.mateIn, cached.depth, {cached.move}});
+                result.nodes = 0;
+                result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                result.stats.seconds = result.seconds;
+                if (onIteration) onIteration(result);
+                return result;
+            }
+            std::rotate(legalMoves.begin(), move, move + 1);
+        }
+    }
+    
+    // Each iteration searches the previous iteration's lines first, best first. An interrupted
+    // iteration is discarded unless no iteration has completed yet.
+    std::vector<SearchLine> lines;
+    for (int depth = 1; depth <= maxDepth && !legalMoves.empty(); ++depth) {
+        for (auto line = result.lines.rbegin(); line != result.lines.rend(); ++line) {
+            auto move = std::find(legalMoves.begin(), legalMoves.end(), line->move);
+            std::rotate(legalMoves.begin(), move, move + 1);
+        }
+        
+        TRACE_SCOPE("depth", depth);
+        uint64_t iterationNodes = state.nodes;
+        auto iterationStart = std::chrono::steady_clock::now();
+        int score = searchRoot(legalMoves, depth, state, lines, multiPV);
+        if (state.stopped && (result.depth > 0 || score == NO_SCORE)) {
+            break;
+        }
+        
+        result.lines = lines;
+        result.bestMove = lines[0].move;
+        result.score = score;
+        if (state.stopped) {
+            break;
+        }
+        result.depth = depth;
+        result.mateIn = lines[0].mateIn;
+        state.stats.depths.push_back({depth, state.nodes - iterationNodes,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - iterationStart).count()});
+        
+        if (onIteration) {
+            result.nodes = state.nodes;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.stats = state.stats;
+            result.stats.nodes = result.nodes;
+            result.stats.seconds = result.seconds;
+            onIteration(result);
+        }
+        if (result.mateIn != 0 && !limits.infinite) {
+            break; // No shorter mate exists at greater depth
+        }
+    }
+    
+    result.nodes = state.nodes;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stats = state.stats;
+    result.stats.nodes = result.nodes;
+    result.stats.seconds = result.seconds;
+    if (limits.cache && result.depth > 0 && cacheableSearch(board, positionHistory.size(), result.depth)) {
+        limits.cache->store(board.getZobristKey(), {result.bestMove, result.score, result.mateIn, result.depth, result.nodes});
+    }
+    return result;
+}
+
+// Mate scores carry the remaining depth at the mated node, which depends on the depth the node
+// was searched with. The transposition table stores them as plies from the node to the mate
+// instead: MATE_SCORE minus the plies.
+static const int MAX_TT_MATE_PLIES = 256;
+
+static int scoreToTT(int score, int depth) {
+    if (std::abs(score) < MATE_SCORE) {
+        return score;
+    }
+    return score > 0 ? score - depth : score + depth;
+}
+
+// NO_SCORE for a mate beyond the horizon of a search with the given depth, which cannot be scored
+static int scoreFromTT(int score, int depth) {
+    if (std::abs(score) <= MATE_SCORE - MAX_TT_MATE_PLIES) {
+        return score;
+    }
+    score = score > 0 ? score + depth : score - depth;
+    return std::abs(score) >= MATE_SCORE ? score : NO_SCORE;
+}
+
+// Moves to mate for a score found at the given depth; mate scores carry the remaining depth at
+// the mated node
+static int mateInFromScore(int score, int depth) {
+    if (std::abs(score) < MATE_SCORE) {
+        return 0;
+    }
+    int plies = depth - (std::abs(score) - MATE_SCORE);
+    return (score > 0 ? 1 : -1) * (plies + 1) / 2;
+}
+
+// Searches every root move and keeps the best multiPV of them in lines, best first. Each move is
+// searched with a window that only admits scores better than the last kept line, so only the kept
+// lines get exact scores. Returns the best score (White's point of view), or NO_SCORE if the
+// limits stopped the search before the first move was completed.
+int Game::searchRoot(std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& legalMoves, int depth,
+                     SearchState& state, std::vector<SearchLine>& lines, int multiPV) const {
+    lines.clear();
     for (const auto& move : legalMoves) {
+        // White maximises the evaluation, Black minimises it
+        bool full = static_cast<int>(lines.size()) >= multiPV;
+        int alpha = currentPlayer && full ? lines.back().score : -SCORE_INFINITY;
+        int beta = !currentPlayer && full ? lines.back().score : SCORE_INFINITY;
+        
         // Create a temporary board to evaluate the move
         Board tempBoard = board;
         tempBoard.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+        if (state.tt && depth > 1) {
+            state.tt->prefetch(tempBoard.getZobristKey());
+        }
         
-        int moveValue = minimax(tempBoard, depth - 1, -10000, 10000, false);
+        state.keyStack.push_back(tempBoard.getZobristKey());
+        int moveValue = minimax(tempBoard, depth - 1, alpha, beta, !currentPlayer, state);
+        state.keyStack.pop_back();
+        if (state.stopped) {
+            break;
+        }
+        if (full && (currentPlayer ? moveValue <= alpha : moveValue >= beta)) {
+            continue;
+        }
         
-        if (moveValue > bestValue) {
-            bestValue = moveValue;
-            bestMove = move;
+        SearchLine line;
+        line.move = move;
+        line.score = moveValue;
+        line.mateIn = mateInFromScore(moveValue, depth);
+        line.depth = depth;
+        line.pv.push_back(move);
+        auto childPV = state.pvMoves.begin() + state.pvStride;
+        line.pv.insert(line.pv.end(), childPV, childPV + state.pvLength[1]);
+        
+        // After the lines that score at least as well, so earlier moves win ties
+        auto position = std::find_if(lines.begin(), lines.end(), [&](const SearchLine& other) {
+            return currentPlayer ? other.score < moveValue : other.score > moveValue;
+        });
+        lines.insert(position, line);
+        if (static_cast<int>(lines.size()) > multiPV) {
+            lines.pop_back();
         }
     }
     
-    return bestMove;
+    return lines.empty() ? NO_SCORE : lines.front().score;
+}
+
+void Game::SearchState::initPV(int rootKeys, int maxDepth) {
+    rootPly = rootKeys;
+    pvStride = maxDepth + 2;
+    pvMoves.assign(static_cast<size_t>(pvStride) * pvStride, {{-1, -1}, {-1, -1}});
+    pvLength.assign(pvStride, 0);
+}
+
+// The line from ply becomes move followed by the line from the child
+void Game::SearchState::updatePV(int ply, const std::pair<std::pair<int, int>, std::pair<int, int>>& move) {
+    auto row = pvMoves.begin() + ply * pvStride;
+    auto child = row + pvStride;
+    row[0] = move;
+    std::copy(child, child + pvLength[ply + 1], row + 1);
+    pvLength[ply] = pvLength[ply + 1] + 1;
+}
+
+bool Game::searchLimitReached(SearchState& state) const {
+    ++state.nodes;
+    if (state.nodeLimit && state.nodes >= state.nodeLimit) {
+        state.stopped = true;
+    } else if (state.nodes % SEARCH_POLL_NODES == 0) {
+        if ((state.stopFlag && state.stopFlag->load(std::memory_order_relaxed)) ||
+            (state.hasDeadline && std::chrono::steady_clock::now() >= state.deadline)) {
+            state.stopped = true;
+        }
+    }
+    return state.stopped;
 }
 
 int Game::evaluatePosition() const {
@@ -641,76 +1115,171 @@ int Game::evaluatePosition() const {
     return score;
 }
 
-int Game::minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer) const {
-    if (depth == 0 || board.isCheckmate(true) || board.isCheckmate(false) || board.isStalemate(true) || board.isStalemate(false)) {
+bool Game::isDrawnPosition(const Board& node, const std::vector<uint64_t>& keyStack) const {
+    if (node.getHalfmoveClock() >= 100 || node.isInsufficientMaterial()) {
+        return true;
+    }
+    
+    // Repetition: only positions since the last irreversible move can recur, and only
+    // with the same side to move
+    int last = static_cast<int>(keyStack.size()) - 1;
+    int limit = std::max(0, last - node.getHalfmoveClock());
+    for (int i = last - 2; i >= limit; i -= 2) {
+        if (keyStack[i] == keyStack[last]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int Game::minimax(Board& board, int depth, int alpha, int beta, bool maximizingPlayer, SearchState& state) const {
+    int ply = static_cast<int>(state.keyStack.size()) - state.rootPly;
+    state.pvLength[ply] = 0;
+    if (state.stopped || searchLimitReached(state)) {
+        return 0; // Discarded by searchRoot
+    }
+    if (isDrawnPosition(board, state.keyStack)) {
+        return 0;
+    }
+    
+    // maximizingPlayer is White to move. Checkmate and stalemate come from the move
+    // generator; mates found with more depth left (nearer the root) score higher.
+    if (depth == 0) {
+        SEARCH_STAT(state.stats.leafNodes++);
+        if (!board.hasLegalMoves(maximizingPlayer)) {
+            return board.isCheck(maximizingPlayer) ? (maximizingPlayer ? -MATE_SCORE : MATE_SCORE) : 0;
+        }
         return board.evaluatePosition();
     }
     
+    // A stored result at least as deep whose bound decides this window ends the node; otherwise
+    // its move is searched first
+    std::pair<std::pair<int, int>, std::pair<int, int>> ttMove = {{-1, -1}, {-1, -1}};
+    if (state.tt) {
+        TTEntry entry;
+        SEARCH_STAT(state.stats.ttProbes++);
+        bool hit;
+        {
+            TRACE_SCOPE("tt");
+            hit = state.tt->probe(board.getZobristKey(), entry);
+        }
+        if (hit) {
+            SEARCH_STAT(state.stats.ttHits++);
+            ttMove = entry.move;
+            int score = scoreFromTT(entry.score, depth);
+            if (entry.depth >= depth && score != NO_SCORE &&
+                (entry.bound == TTBound::EXACT || (entry.bound == TTBound::LOWER && score >= beta) ||
+                 (entry.bound == TTBound::UPPER && score <= alpha))) {
+                SEARCH_STAT(state.stats.ttCutoffs++);
+                if (entry.bound == TTBound::EXACT && ttMove.first.first >= 0) {
+                    state.pvMoves[ply * state.pvStride] = ttMove;
+                    state.pvLength[ply] = 1;
+                }
+                return score;
+            }
+        }
+    }
+    
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> legalMoves;
+    board.generateLegalMoves(maximizingPlayer, legalMoves);
+    if (legalMoves.empty()) {
+        if (board.isCheck(maximizingPlayer)) {
+            return maximizingPlayer ? -(MATE_SCORE + depth) : MATE_SCORE + depth;
+        }
+        return 0; // Stalemate
+    }
+    if (ttMove.first.first >= 0) {
+        auto move = std::find(legalMoves.begin(), legalMoves.end(), ttMove);
+        if (move != legalMoves.end()) {
+            std::rotate(legalMoves.begin(), move, move + 1);
+        }
+    }
+    
+    int alphaOrig = alpha;
+    int betaOrig = beta;
+    int bestEval;
+    const std::pair<std::pair<int, int>, std::pair<int, int>>* bestMove = nullptr;
     if (maximizingPlayer) {
-        int maxEval = -10000;
-        auto legalMoves = getAllLegalMoves(true);
+        int maxEval = -SCORE_INFINITY;
         
         for (const auto& move : legalMoves) {
             Board tempBoard = board;
             tempBoard.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+            if (state.tt && depth > 1) {
+                state.tt->prefetch(tempBoard.getZobristKey());
+            }
             
-            int eval = minimax(tempBoard, depth - 1, alpha, beta, false);
+            state.keyStack.push_back(tempBoard.getZobristKey());
+            int eval = minimax(tempBoard, depth - 1, alpha, beta, false, state);
+            state.keyStack.pop_back();
             maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
+            if (eval > alpha) {
+                alpha = eval;
+                bestMove = &move;
+                state.updatePV(ply, move);
+            }
             
             if (beta <= alpha) {
+                SEARCH_STAT(state.stats.cutoffs++);
+                SEARCH_STAT(state.stats.firstMoveCutoffs += &move == &legalMoves[0]);
                 break; // Alpha-beta pruning
             }
         }
-        return maxEval;
+        bestEval = maxEval;
     } else {
-        int minEval = 10000;
-        auto legalMoves = getAllLegalMoves(false);
+        int minEval = SCORE_INFINITY;
         
         for (const auto& move : legalMoves) {
             Board tempBoard = board;
             tempBoard.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+            if (state.tt && depth > 1) {
+                state.tt->prefetch(tempBoard.getZobristKey());
+            }
             
-            int eval = minimax(tempBoard, depth - 1, alpha, beta, true);
+            state.keyStack.push_back(tempBoard.getZobristKey());
+            int eval = minimax(tempBoard, depth - 1, alpha, beta, true, state);
+            state.keyStack.pop_back();
             minEval = std::min(minEval, eval);
-            beta = std::min(beta, eval);
+            if (eval < beta) {
+                beta = eval;
+                bestMove = &move;
+                state.updatePV(ply, move);
+            }
             
             if (beta <= alpha) {
+                SEARCH_STAT(state.stats.cutoffs++);
+                SEARCH_STAT(state.stats.firstMoveCutoffs += &move == &legalMoves[0]);
                 break; // Alpha-beta pruning
             }
         }
-        return minEval;
-    }
+        bestEval = minEval;
+    }
+    
+    // Scores are White's, so a score at or below the original alpha is an upper bound for either
+    // side to move and one at or above beta a lower bound
+    if (state.tt && !state.stopped) {
+        TTEntry entry;
+        entry.move = bestMove ? *bestMove : ttMove;
+        entry.score = scoreToTT(bestEval, depth);
+        entry.depth = depth;
+        entry.bound = bestEval <= alphaOrig ? TTBound::UPPER : bestEval >= betaOrig ? TTBound::LOWER : TTBound::EXACT;
+        bool replaced = state.tt->store(board.getZobristKey(), entry);
+        (void)replaced; // Only counted with search statistics
+        SEARCH_STAT(state.stats.ttStores++);
+        SEARCH_STAT(state.stats.ttCollisions += replaced);
+    }
+    return bestEval;
 }
 
 std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> Game::getAllLegalMoves(bool forWhite) const {
     std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> legalMoves;
-    
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            Piece* piece = board.getPiece(i, j);
-            if (piece && piece->isWhite() == forWhite) {
-                auto moves = board.getLegalMoves(i, j);
-                for (const auto& move : moves) {
-                    legalMoves.push_back({{i, j}, move});
-                }
-            }
-        }
-    }
-    
+    board.generateLegalMoves(forWhite, legalMoves);
     return legalMoves;
 }
 
 int Game::getPieceValue(char piece) const {
-    switch (toupper(piece)) {
-        case 'P': return 1;   // Pawn
-        case 'N': return 3;   // Knight
-        case 'B': return 3;   // Bishop
-        case 'R': return 5;   // Rook
-        case 'Q': return 9;   // Queen
-        case 'K': return 100; // King
-        default: return 0;
-    }
+    PieceType type = pieceTypeFromSymbol(piece);
+    return type == PIECE_TYPE_COUNT ? 0 : getEvalParams().pieceValues[type];
 }
 
 void Game::displayAISettings() const {
@@ -756,8 +1325,9 @@ bool Game::saveGame(const std::string& filename) const {
         file << "AIPlaysAsWhite: " << (aiPlaysAsWhite ? "true" : "false") << "\n";
     }
     
-    // Save board state as FEN
+    // Save board state as FEN, plus the position the move history starts from
     file << "FEN: " << getFEN() << "\n";
+    file << "StartFEN: " << startFEN << "\n";
     
     // Save move history
     file << "MOVE_HISTORY\n";
@@ -781,6 +1351,7 @@ bool Game::loadGame(const std::string& filename) {
     
     std::string line;
     std::string fen;
+    std::string savedStartFEN = START_FEN;
     std::vector<std::string> moves;
     bool inMoveHistory = false;
     
@@ -792,6 +1363,8 @@ bool Game::loadGame(const std::string& filename) {
             continue;
         } else if (line.substr(0, 4) == "FEN:") {
             fen = line.substr(5); // Remove "FEN: " prefix
+        } else if (line.substr(0, 9) == "StartFEN:") {
+            savedStartFEN = line.substr(10);
         } else if (line.substr(0, 14) == "CurrentPlayer:") {
             currentPlayer = (line.substr(15) == "White");
         } else if (line.substr(0, 10) == "MoveCount:") {
@@ -809,27 +1382,31 @@ bool Game::loadGame(const std::string& filename) {
     
     file.close();
     
-    // Set the board state from FEN
-    if (!fen.empty()) {
-        if (!setFEN(fen)) {
-            std::cout << "Error: Invalid FEN in save file.\n";
-            return false;
-        }
+    // Rebuild the history by replaying the moves quietly from the start position. If they do not
+    // lead to the saved position (compared by key, as older saves have no halfmove clock), the
+    // game continues from it without a history.
+    if (!setFEN(savedStartFEN)) {
+        std::cout << "Error: Invalid StartFEN in save file.\n";
+        return false;
     }
-    
-    // Reconstruct move history
-    moveHistory.clear();
-    for (const auto& moveStr : moves) {
-        std::istringstream iss(moveStr);
+    bool replayed = true;
+    for (size_t i = 0; replayed && i < moves.size(); ++i) {
+        std::istringstream iss(moves[i]);
         std::string from, to;
         iss >> from >> to;
-        
         auto fromCoords = parseChessNotation(from);
         auto toCoords = parseChessNotation(to);
-        
-        if (fromCoords.first != -1 && toCoords.first != -1) {
-            moveHistory.emplace_back(fromCoords.first, fromCoords.second, toCoords.first, toCoords.second);
+        replayed = applyMove(fromCoords.first, fromCoords.second, toCoords.first, toCoords.second);
+    }
+    Board saved;
+    if (!fen.empty() && (!replayed || !saved.loadFEN(fen) || saved.getZobristKey() != board.getZobristKey())) {
+        if (!setFEN(fen)) {
+            std::cout << "Error: Invalid FEN in save file.\n";
+            return false;
         }
+        std::cout << "Warning: The move history does not lead to the saved position; it was dropped.\n";
+    } else if (!replayed) {
+        std::cout << "Warning: The move history has an illegal move; it was loaded up to ply " << getPly() << ".\n";
     }
     
     std::cout << "Game loaded from " << filename << "\n";
@@ -853,7 +1430,7 @@ bool Game::exportPGN(const std::string& filename) const {
     file << "[White \"Player 1\"]\n";
     file << "[Black \"Player 2\"]\n";
     file << "[Result \"*\"]\n";
-    file << "[FEN \"" << getFEN() << "\"]\n\n";
+    file << "[FEN \"" << startFEN << "\"]\n\n";
     
     // Moves
     for (size_t i = 0; i < moveHistory.size(); i += 2) {
@@ -914,37 +1491,25 @@ bool Game::importPGN(const std::string& filename) {
     file.close();
     
     // Reset game
-    board.resetBoard();
-    moveHistory.clear();
-    moveCount = 0;
-    currentPlayer = true;
-    
-    // Set initial position from FEN if provided
-    if (!fen.empty()) {
-        if (!setFEN(fen)) {
-            std::cout << "Error: Invalid FEN in PGN file.\n";
-            return false;
-        }
+    if (!setFEN(fen.empty() ? START_FEN : fen)) {
+        std::cout << "Error: Invalid FEN in PGN file.\n";
+        return false;
     }
     
-    // Execute moves
+    // Replay quietly, stopping at the first move that is not legal
+    int played = 0;
     for (const auto& moveStr : moves) {
-        std::string from = moveStr.substr(0, 2);
-        std::string to = moveStr.substr(2, 2);
-        
-        auto fromCoords = parseChessNotation(from);
-        auto toCoords = parseChessNotation(to);
-        
-        if (fromCoords.first != -1 && toCoords.first != -1) {
-            if (makeMove(fromCoords.first, fromCoords.second, toCoords.first, toCoords.second)) {
-                moveCount++;
-                currentPlayer = !currentPlayer;
-            }
+        auto fromCoords = parseChessNotation(moveStr.substr(0, 2));
+        auto toCoords = parseChessNotation(moveStr.substr(2, 2));
+        if (!applyMove(fromCoords.first, fromCoords.second, toCoords.first, toCoords.second)) {
+            std::cout << "Error: Illegal move " << moveStr << " at ply " << played + 1 << "; import stopped there.\n";
+            break;
         }
+        played++;
     }
     
     std::cout << "PGN imported from " << filename << "\n";
-    std::cout << "Loaded " << moves.size() << " moves\n";
+    std::cout << "Loaded " << played << " moves\n";
     return true;
 }
 
@@ -994,7 +1559,7 @@ std::string Game::getFEN() const {
     }
     
     // Halfmove clock and fullmove number
-    fen += " 0 " + std::to_string(moveCount / 2 + 1);
+    fen += " " + std::to_string(board.getHalfmoveClock()) + " " + std::to_string(moveCount / 2 + 1);
     
     return fen;
 }
@@ -1005,35 +1570,24 @@ bool Game::setFEN(const std::string& fen) {
     
     iss >> position >> activeColor >> castling >> enPassant >> halfmove >> fullmove;
     
-    // Reset board
-    board.resetBoard();
-    
-    // Parse position
-    int row = 0, col = 0;
-    for (char c : position) {
-        if (c == '/') {
-            row++;
-            col = 0;
-        } else if (isdigit(c)) {
-            col += c - '0';
-        } else {
-            // Place piece
-            bool isWhite = isupper(c);
-            char pieceType = tolower(c);
-            
-            // This is a simplified version - in a full implementation,
-            // you'd need to properly place pieces on the board
-            // For now, we'll just validate the FEN format
-            col++;
-        }
+    if (activeColor != "w" && activeColor != "b") {
+        return false;
+    }
+    
+    // Place pieces, castling rights and en passant square
+    if (!board.loadFEN(fen)) {
+        return false;
     }
     
     // Set current player
     currentPlayer = (activeColor == "w");
     
-    // Reset game state
-    moveHistory.clear();
-    moveCount = 0;
+    // Reset game state; the move counter continues from the fullmove number
+    resetHistory();
+    int fullmoveNumber = std::atoi(fullmove.c_str());
+    if (fullmoveNumber < 1) fullmoveNumber = 1;
+    moveCount = (fullmoveNumber - 1) * 2 + (currentPlayer ? 0 : 1);
+    startFEN = fen;
     
     return true;
 }
@@ -0,0 +1,68 @@
+#include "../include/MappedFile.h"
+#include <iostream>
+#ifdef _WIN32
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& filename, bool randomAccess) {
+    close();
+#ifdef _WIN32
+    (void)randomAccess;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for reading.\n";
+        return false;
+    }
+    std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (contents.empty()) {
+        std::cerr << "Error: " << filename << " is empty.\n";
+        return false;
+    }
+    char* copy = new char[contents.size()];
+    std::memcpy(copy, contents.data(), contents.size());
+    bytes = copy;
+    length = contents.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open file " << filename << " for reading.\n";
+        return false;
+    }
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: Could not map file " << filename << ".\n";
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (randomAccess) {
+        madvise(mapped, length, MADV_RANDOM);
+    }
+    bytes = static_cast<const char*>(mapped);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) {
+#ifdef _WIN32
+        delete[] bytes;
+#else
+        munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+    bytes = nullptr;
+    length = 0;
+}
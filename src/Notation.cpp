@@ -0,0 +1,166 @@
+#include "../include/Notation.h"
+#include "../include/Board.h"
+#include <cstdlib>
+#include <vector>
+
+std::string squareToNotation(int x, int y) {
+    char file = 'a' + y;
+    char rank = '0' + (8 - x);
+    return std::string(1, file) + rank;
+}
+
+std::pair<int, int> notationToSquare(const std::string& notation) {
+    if (notation.length() != 2) {
+        return {-1, -1};
+    }
+    
+    char file = notation[0];
+    char rank = notation[1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
+        return {-1, -1};
+    }
+    
+    return {8 - (rank - '0'), file - 'a'};
+}
+
+std::string moveToNotation(int x1, int y1, int x2, int y2) {
+    return squareToNotation(x1, y1) + squareToNotation(x2, y2);
+}
+
+std::pair<std::pair<int, int>, std::pair<int, int>> parseCoordinateMove(const std::string& move) {
+    if (move.length() != 4 && move.length() != 5) {
+        return {{-1, -1}, {-1, -1}};
+    }
+    
+    auto from = notationToSquare(move.substr(0, 2));
+    auto to = notationToSquare(move.substr(2, 2));
+    if (from.first == -1 || to.first == -1) {
+        return {{-1, -1}, {-1, -1}};
+    }
+    
+    return {from, to};
+}
+
+std::pair<std::pair<int, int>, std::pair<int, int>> parseMove(const Board& board, const std::string& move) {
+    const std::pair<std::pair<int, int>, std::pair<int, int>> invalid = {{-1, -1}, {-1, -1}};
+    bool white = board.isWhiteToMove();
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> legalMoves;
+    board.generateLegalMoves(white, legalMoves);
+    
+    // Drop check marks and annotation glyphs
+    std::string san = move;
+    while (!san.empty() && std::string("+#!?").find(san.back()) != std::string::npos) {
+        san.pop_back();
+    }
+    
+    // Coordinate notation
+    auto coordinate = parseCoordinateMove(san);
+    if (coordinate.first.first != -1) {
+        for (const auto& legal : legalMoves) {
+            if (legal == coordinate) return legal;
+        }
+        return invalid;
+    }
+    
+    // Castling is a two-square king move
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        int row = white ? 7 : 0;
+        std::pair<std::pair<int, int>, std::pair<int, int>> castle = {{row, 4}, {row, san.length() == 3 ? 6 : 2}};
+        for (const auto& legal : legalMoves) {
+            if (legal == castle && pieceCodeType(board.getPieceCode(row, 4)) == KING) return legal;
+        }
+        return invalid;
+    }
+    
+    // Promotion suffix ("e8=Q" or "e8Q"); pawns always promote to a queen
+    size_t equals = san.find('=');
+    if (equals != std::string::npos) {
+        san.erase(equals);
+    } else if (san.length() >= 3 && std::string("QRBN").find(san.back()) != std::string::npos &&
+               (san[san.length() - 2] == '1' || san[san.length() - 2] == '8')) {
+        san.pop_back();
+    }
+    if (san.length() < 2) return invalid;
+    
+    PieceType type = PAWN;
+    size_t start = 0;
+    if (std::string("KQRBN").find(san[0]) != std::string::npos) {
+        type = pieceTypeFromSymbol(san[0]);
+        start = 1;
+    }
+    
+    auto to = notationToSquare(san.substr(san.length() - 2));
+    if (to.first == -1) return invalid;
+    
+    // Whatever remains between the piece letter and the destination disambiguates the origin
+    std::string hint;
+    for (size_t i = start; i + 2 < san.length(); ++i) {
+        char c = san[i];
+        if (c == 'x' || c == '-') continue;
+        if ((c < 'a' || c > 'h') && (c < '1' || c > '8')) return invalid;
+        hint += c;
+    }
+    
+    std::pair<std::pair<int, int>, std::pair<int, int>> match = invalid;
+    int matches = 0;
+    for (const auto& legal : legalMoves) {
+        if (legal.second != to || pieceCodeType(board.getPieceCode(legal.first.first, legal.first.second)) != type) {
+            continue;
+        }
+        bool fits = true;
+        for (char c : hint) {
+            if (c >= 'a' && c <= 'h' ? legal.first.second != c - 'a' : legal.first.first != 8 - (c - '0')) {
+                fits = false;
+            }
+        }
+        if (fits) {
+            match = legal;
+            matches++;
+        }
+    }
+    return matches == 1 ? match : invalid;
+}
+
+std::string moveToSAN(const Board& board, const std::pair<std::pair<int, int>, std::pair<int, int>>& move) {
+    int x1 = move.first.first, y1 = move.first.second;
+    int x2 = move.second.first, y2 = move.second.second;
+    int type = pieceCodeType(board.getPieceCode(x1, y1));
+    bool white = board.isWhiteToMove();
+    std::string san;
+    
+    if (type == KING && std::abs(y2 - y1) == 2) {
+        san = y2 > y1 ? "O-O" : "O-O-O";
+    } else {
+        bool capture = board.getPieceCode(x2, y2) != NO_PIECE || (type == PAWN && y1 != y2);
+        if (type == PAWN) {
+            if (capture) san += static_cast<char>('a' + y1);
+        } else {
+            san += "PNBRQK"[type];
+            
+            // Disambiguate by file, then rank, then both
+            std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> legalMoves;
+            board.generateLegalMoves(white, legalMoves);
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (const auto& other : legalMoves) {
+                if (other.second == move.second && other.first != move.first &&
+                    pieceCodeType(board.getPieceCode(other.first.first, other.first.second)) == type) {
+                    ambiguous = true;
+                    sameFile = sameFile || other.first.second == y1;
+                    sameRank = sameRank || other.first.first == x1;
+                }
+            }
+            if (ambiguous && (!sameFile || sameRank)) san += static_cast<char>('a' + y1);
+            if (ambiguous && sameFile) san += static_cast<char>('0' + (8 - x1));
+        }
+        if (capture) san += 'x';
+        san += squareToNotation(x2, y2);
+        if (type == PAWN && (x2 == 0 || x2 == 7)) san += "=Q";
+    }
+    
+    Board after = board;
+    after.movePiece(x1, y1, x2, y2);
+    if (after.isCheck(!white)) {
+        san += after.hasLegalMoves(!white) ? '+' : '#';
+    }
+    return san;
+}
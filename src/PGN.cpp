@@ -0,0 +1,193 @@
+#include "../include/PGN.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+bool isResultToken(const std::string& token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// Parses [Name "Value"], unescaping \" and \\ in the value
+bool parseTag(const std::string& line, std::pair<std::string, std::string>& tag) {
+    size_t nameEnd = line.find(' ');
+    size_t valueStart = line.find('"');
+    if (nameEnd == std::string::npos || valueStart == std::string::npos || valueStart < nameEnd) {
+        return false;
+    }
+    
+    tag.first = line.substr(1, nameEnd - 1);
+    tag.second.clear();
+    for (size_t i = valueStart + 1; i < line.length() && line[i] != '"'; ++i) {
+        if (line[i] == '\\' && i + 1 < line.length()) {
+            ++i;
+        }
+        tag.second += line[i];
+    }
+    return true;
+}
+
+} // namespace
+
+std::string PGNGame::tag(const std::string& name) const {
+    for (const auto& entry : tags) {
+        if (entry.first == name) return entry.second;
+    }
+    return "";
+}
+
+bool readPGNGame(std::istream& in, PGNGame& game) {
+    game = PGNGame();
+    std::string line;
+    bool inMoves = false;
+    bool inComment = false;  // Inside { ... }, which may span lines
+    int variationDepth = 0;  // Inside ( ... ), which may nest
+    
+    while (true) {
+        // A tag line after movetext without a result starts the next game
+        if (inMoves && !inComment && variationDepth == 0 && in.peek() == '[') {
+            return true;
+        }
+        if (!std::getline(in, line)) {
+            return inMoves || !game.tags.empty();
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        
+        if (!inMoves && !line.empty() && line[0] == '[') {
+            std::pair<std::string, std::string> tag;
+            if (parseTag(line, tag)) {
+                game.tags.push_back(tag);
+            }
+            continue;
+        }
+        if (line.empty() || line[0] == '%') {
+            continue; // Blank separator or escape line
+        }
+        inMoves = true;
+        
+        std::string token;
+        for (size_t i = 0; i <= line.length(); ++i) {
+            char c = i < line.length() ? line[i] : ' ';
+            if (inComment) {
+                inComment = c != '}';
+                continue;
+            }
+            
+            bool separator = c == ' ' || c == '\t' || c == '{' || c == '(' || c == ')' || c == ';';
+            if (!separator) {
+                token += c;
+                continue;
+            }
+            
+            if (!token.empty() && variationDepth == 0) {
+                if (isResultToken(token)) {
+                    game.result = token;
+                    return true;
+                }
+                
+                // Strip move numbers ("12.", "12...", "12.e4") and skip NAGs ("$1")
+                std::string move = token;
+                size_t digits = token.find_first_not_of("0123456789");
+                if (digits != std::string::npos && digits > 0 && token[digits] == '.') {
+                    size_t start = token.find_first_not_of('.', digits);
+                    move = start == std::string::npos ? "" : token.substr(start);
+                } else if (digits == std::string::npos) {
+                    move.clear();
+                }
+                if (!move.empty() && move[0] != '$') {
+                    game.moves.push_back(move);
+                }
+            }
+            token.clear();
+            
+            if (c == '{') inComment = true;
+            else if (c == '(') variationDepth++;
+            else if (c == ')' && variationDepth > 0) variationDepth--;
+            else if (c == ';') break; // Comment to end of line
+        }
+    }
+}
+
+void writePGNTags(std::ostream& out, const PGNGame& game) {
+    for (const auto& tag : game.tags) {
+        out << "[" << tag.first << " \"";
+        for (char c : tag.second) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << "\"]\n";
+    }
+    out << "\n";
+}
+
+bool splitPGNFile(const std::string& file, uint64_t shardBytes, std::vector<PGNShard>& shards) {
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open file " << file << " for reading.\n";
+        return false;
+    }
+    uint64_t size = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    
+    std::string line, startTag;
+    while (std::getline(in, line) && line.find_first_not_of(" \t\r") == std::string::npos) {
+    }
+    size_t space = line.find(' ');
+    if (!line.empty() && line[0] == '[' && space != std::string::npos) {
+        startTag = line.substr(0, space + 1);
+    }
+    
+    if (startTag.empty() || shardBytes == 0) {
+        shards.push_back({file, 0, size, startTag});
+        return true;
+    }
+    for (uint64_t begin = 0; begin < size; begin += shardBytes) {
+        shards.push_back({file, begin, std::min(size, begin + shardBytes), startTag});
+    }
+    return true;
+}
+
+bool PGNShardReader::open(const PGNShard& shard) {
+    in.close();
+    in.clear();
+    in.open(shard.file, std::ios::binary);
+    end = shard.end;
+    if (!in.is_open()) {
+        return false;
+    }
+    if (shard.begin == 0) {
+        return true;
+    }
+    
+    // Skip to the first line at or after the shard's beginning that opens a game
+    std::string line;
+    in.seekg(shard.begin - 1);
+    std::getline(in, line); // Rest of the line holding the byte before the shard
+    while (true) {
+        std::streampos position = in.tellg();
+        if (!std::getline(in, line)) {
+            return false;
+        }
+        if (line.compare(0, shard.startTag.length(), shard.startTag) == 0) {
+            in.seekg(position);
+            return true;
+        }
+    }
+}
+
+bool PGNShardReader::next(PGNGame& game, uint64_t& offset) {
+    // Whitespace left after a result token belongs to no game
+    int c = in.peek();
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        in.get();
+        c = in.peek();
+    }
+    std::streamoff start = in.tellg();
+    if (start < 0 || static_cast<uint64_t>(start) >= end || !readPGNGame(in, game)) {
+        return false;
+    }
+    offset = static_cast<uint64_t>(start);
+    return true;
+}
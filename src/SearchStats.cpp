@@ -0,0 +1,100 @@
+#include "../include/SearchStats.h"
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+std::string formatDouble(double value, int decimals) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return buffer;
+}
+
+} // namespace
+
+double SearchStats::nodesPerSecond() const {
+    return seconds > 0 ? nodes / seconds : 0;
+}
+
+double SearchStats::branchingFactor() const {
+    if (depths.size() < 2 || depths[depths.size() - 2].nodes == 0) {
+        return 0;
+    }
+    return static_cast<double>(depths.back().nodes) / depths[depths.size() - 2].nodes;
+}
+
+double SearchStats::firstMoveCutoffRate() const {
+    return cutoffs ? static_cast<double>(firstMoveCutoffs) / cutoffs : 0;
+}
+
+double SearchStats::ttHitRate() const {
+    return ttProbes ? static_cast<double>(ttHits) / ttProbes : 0;
+}
+
+void SearchStats::merge(const SearchStats& other) {
+    nodes += other.nodes;
+    leafNodes += other.leafNodes;
+    cutoffs += other.cutoffs;
+    firstMoveCutoffs += other.firstMoveCutoffs;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    ttStores += other.ttStores;
+    ttCollisions += other.ttCollisions;
+    seconds += other.seconds;
+    for (const auto& entry : other.depths) {
+        size_t index = 0;
+        while (index < depths.size() && depths[index].depth < entry.depth) {
+            index++;
+        }
+        if (index < depths.size() && depths[index].depth == entry.depth) {
+            depths[index].nodes += entry.nodes;
+            depths[index].seconds += entry.seconds;
+        } else {
+            depths.insert(depths.begin() + index, entry);
+        }
+    }
+}
+
+void SearchStats::print(std::ostream& out) const {
+    out << "Nodes:              " << nodes << "\n";
+    out << "Leaf nodes:         " << leafNodes << "\n";
+    out << "Time:               " << formatDouble(seconds * 1000, 1) << " ms\n";
+    out << "Nodes/sec:          " << static_cast<uint64_t>(nodesPerSecond()) << "\n";
+    out << "Branching factor:   " << formatDouble(branchingFactor(), 2) << "\n";
+    out << "Beta cutoffs:       " << cutoffs << " (" << formatDouble(firstMoveCutoffRate() * 100, 1)
+        << "% on the first move)\n";
+    if (ttProbes) {
+        out << "TT hits:            " << ttHits << " of " << ttProbes << " probes ("
+            << formatDouble(ttHitRate() * 100, 1) << "%), " << ttCutoffs << " cutoffs\n";
+        out << "TT stores:          " << ttStores << " (" << ttCollisions << " replaced another position)\n";
+    }
+    for (const auto& entry : depths) {
+        out << "  depth " << entry.depth << ": " << entry.nodes << " nodes, "
+            << formatDouble(entry.seconds * 1000, 1) << " ms\n";
+    }
+}
+
+std::string SearchStats::toJSON() const {
+    std::ostringstream json;
+    json << "{\"nodes\":" << nodes
+         << ",\"leafNodes\":" << leafNodes
+         << ",\"seconds\":" << formatDouble(seconds, 6)
+         << ",\"nps\":" << static_cast<uint64_t>(nodesPerSecond())
+         << ",\"branchingFactor\":" << formatDouble(branchingFactor(), 3)
+         << ",\"cutoffs\":" << cutoffs
+         << ",\"firstMoveCutoffs\":" << firstMoveCutoffs
+         << ",\"firstMoveCutoffRate\":" << formatDouble(firstMoveCutoffRate(), 4)
+         << ",\"ttProbes\":" << ttProbes
+         << ",\"ttHits\":" << ttHits
+         << ",\"ttCutoffs\":" << ttCutoffs
+         << ",\"ttStores\":" << ttStores
+         << ",\"ttCollisions\":" << ttCollisions
+         << ",\"depths\":[";
+    for (size_t i = 0; i < depths.size(); ++i) {
+        json << (i ? "," : "") << "{\"depth\":" << depths[i].depth << ",\"nodes\":" << depths[i].nodes
+             << ",\"seconds\":" << formatDouble(depths[i].seconds, 6) << "}";
+    }
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,133 @@
+#include "../include/Trace.h"
+
+#ifdef CHESS_TRACE
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> traceEnabled(false);
+
+namespace {
+
+const size_t BUFFER_EVENTS = 1 << 18; // Per thread, 24 bytes each
+
+struct TraceEvent {
+    const char* name;
+    int arg;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct TraceBuffer {
+    int threadId;
+    std::vector<TraceEvent> events;
+    size_t next = 0;
+    bool wrapped = false;
+};
+
+// Buffers are never freed, so a thread's pointer stays valid across traces and after it exits
+std::mutex registryMutex;
+std::vector<std::unique_ptr<TraceBuffer>> buffers;
+std::string traceFile;
+uint64_t traceOrigin = 0;
+
+thread_local TraceBuffer* localBuffer = nullptr;
+
+TraceBuffer* registerThread() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+    buffer->threadId = static_cast<int>(buffers.size()) + 1;
+    buffer->events.resize(BUFFER_EVENTS);
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+}
+
+void writeEvent(std::ostream& out, const TraceBuffer& buffer, const TraceEvent& event) {
+    char timing[64];
+    std::snprintf(timing, sizeof(timing), "\"ts\":%.3f,\"dur\":%.3f",
+                  (event.start - traceOrigin) / 1000.0, (event.end - event.start) / 1000.0);
+    out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\"," << timing
+        << ",\"pid\":1,\"tid\":" << buffer.threadId;
+    if (event.arg >= 0) {
+        out << ",\"args\":{\"value\":" << event.arg << "}";
+    }
+    out << "}";
+}
+
+} // namespace
+
+void traceRecord(const char* name, int arg, uint64_t startNs, uint64_t endNs) {
+    TraceBuffer* buffer = localBuffer;
+    if (!buffer) {
+        buffer = localBuffer = registerThread();
+    }
+    buffer->events[buffer->next] = {name, arg, startNs, endNs};
+    if (++buffer->next == BUFFER_EVENTS) {
+        buffer->next = 0;
+        buffer->wrapped = true;
+    }
+}
+
+bool traceCompiledIn() {
+    return true;
+}
+
+bool traceStart(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (traceEnabled.load()) {
+        return false;
+    }
+    for (auto& buffer : buffers) {
+        buffer->next = 0;
+        buffer->wrapped = false;
+    }
+    traceFile = filename;
+    traceOrigin = traceNow();
+    traceEnabled.store(true);
+    return true;
+}
+
+bool traceStop() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (!traceEnabled.exchange(false)) {
+        return false;
+    }
+    
+    std::ofstream out(traceFile);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"chess\"}}";
+    for (const auto& buffer : buffers) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":\"thread " << buffer->threadId << "\"}}";
+        // Oldest first: after a wrap the oldest event is the next one to be overwritten
+        size_t count = buffer->wrapped ? BUFFER_EVENTS : buffer->next;
+        size_t first = buffer->wrapped ? buffer->next : 0;
+        for (size_t i = 0; i < count; ++i) {
+            writeEvent(out, *buffer, buffer->events[(first + i) % BUFFER_EVENTS]);
+        }
+    }
+    out << "\n]}\n";
+    return out.good();
+}
+
+#else
+
+bool traceCompiledIn() {
+    return false;
+}
+
+bool traceStart(const std::string&) {
+    return false;
+}
+
+bool traceStop() {
+    return false;
+}
+
+#endif // CHESS_TRACE
@@ -0,0 +1,176 @@
+#include "../include/TrainingData.h"
+#include "../include/Zobrist.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition is part of the file format");
+
+namespace {
+
+const size_t WRITE_BUFFER_RECORDS = 8192;
+const size_t READ_BUFFER_RECORDS = 8192;
+
+} // namespace
+
+bool packPosition(const Board& board, int score, int result, int ply, PackedPosition& packed) {
+    std::memset(&packed, 0, sizeof(packed));
+    int count = 0;
+    for (int square = 0; square < 64; ++square) {
+        PieceCode code = board.getPieceCode(square / 8, square % 8);
+        if (code == NO_PIECE) {
+            continue;
+        }
+        if (count == 32) {
+            return false;
+        }
+        packed.occupancy |= squareBit(square);
+        packed.pieces[count / 2] |= static_cast<uint8_t>(code << (count % 2 * 4));
+        count++;
+    }
+    
+    packed.score = static_cast<int16_t>(std::max(-32000, std::min(32000, score)));
+    packed.result = static_cast<int8_t>(result);
+    packed.state = static_cast<uint8_t>((board.isWhiteToMove() ? 0 : 1) | board.getCastlingRights() << 1);
+    std::pair<int, int> target = board.getEnPassantTarget();
+    packed.enPassantFile = static_cast<uint8_t>(target.first == -1 ? 0 : target.second + 1);
+    packed.halfmoveClock = static_cast<uint8_t>(std::min(255, board.getHalfmoveClock()));
+    packed.ply = static_cast<uint16_t>(std::min(65535, ply));
+    return true;
+}
+
+std::string packedPositionToFEN(const PackedPosition& packed) {
+    std::string fen;
+    int count = 0;
+    for (int x = 0; x < 8; ++x) {
+        int empty = 0;
+        for (int y = 0; y < 8; ++y) {
+            int square = squareIndex(x, y);
+            if (!(packed.occupancy & squareBit(square))) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            PieceCode code = static_cast<PieceCode>(packed.pieces[count / 2] >> (count % 2 * 4) & 15);
+            fen += pieceCodeSymbol(code);
+            count++;
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (x < 7) fen += '/';
+    }
+    
+    fen += packed.state & 1 ? " b " : " w ";
+    int castling = packed.state >> 1;
+    std::string rights;
+    if (castling & WHITE_KINGSIDE) rights += 'K';
+    if (castling & WHITE_QUEENSIDE) rights += 'Q';
+    if (castling & BLACK_KINGSIDE) rights += 'k';
+    if (castling & BLACK_QUEENSIDE) rights += 'q';
+    fen += rights.empty() ? "-" : rights;
+    
+    if (packed.enPassantFile) {
+        fen += ' ';
+        fen += static_cast<char>('a' + packed.enPassantFile - 1);
+        fen += packed.state & 1 ? '3' : '6';
+    } else {
+        fen += " -";
+    }
+    fen += " " + std::to_string(packed.halfmoveClock) + " " + std::to_string(packed.ply / 2 + 1);
+    return fen;
+}
+
+bool unpackPosition(const PackedPosition& packed, Board& board) {
+    return board.loadFEN(packedPositionToFEN(packed));
+}
+
+bool TrainingDataWriter::open(const std::string& filename, double syncSeconds) {
+    close();
+    file = std::fopen(filename.c_str(), "ab");
+    if (!file) {
+        std::cerr << "Error: Could not open file " << filename << " for writing.\n";
+        return false;
+    }
+    this->syncSeconds = syncSeconds;
+    lastSync = std::chrono::steady_clock::now();
+    records = 0;
+    failed = false;
+    buffer.reserve(WRITE_BUFFER_RECORDS);
+    return true;
+}
+
+bool TrainingDataWriter::write(const std::vector<PackedPosition>& positions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    buffer.insert(buffer.end(), positions.begin(), positions.end());
+    records += positions.size();
+    bool syncDue = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastSync).count() >= syncSeconds;
+    if (buffer.size() < WRITE_BUFFER_RECORDS && !syncDue) {
+        return !failed;
+    }
+    return flush(syncDue);
+}
+
+bool TrainingDataWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return !failed;
+    }
+    flush(true);
+    if (std::fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+    return !failed;
+}
+
+bool TrainingDataWriter::flush(bool sync) {
+    if (!buffer.empty() && std::fwrite(buffer.data(), sizeof(PackedPosition), buffer.size(), file) != buffer.size()) {
+        failed = true;
+    }
+    buffer.clear();
+    if (sync) {
+        if (std::fflush(file) != 0) {
+            failed = true;
+        }
+#ifndef _WIN32
+        if (fsync(fileno(file)) != 0) {
+            failed = true;
+        }
+#endif
+        lastSync = std::chrono::steady_clock::now();
+    }
+    return !failed;
+}
+
+bool TrainingDataReader::open(const std::string& filename) {
+    in.close();
+    in.clear();
+    in.open(filename, std::ios::binary);
+    buffer.clear();
+    position = 0;
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for reading.\n";
+        return false;
+    }
+    return true;
+}
+
+bool TrainingDataReader::read(PackedPosition& packed) {
+    if (position >= buffer.size()) {
+        buffer.resize(READ_BUFFER_RECORDS);
+        in.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(PackedPosition));
+        buffer.resize(static_cast<size_t>(in.gcount()) / sizeof(PackedPosition));
+        position = 0;
+        if (buffer.empty()) {
+            return false;
+        }
+    }
+    packed = buffer[position++];
+    return true;
+}
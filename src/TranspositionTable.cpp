@@ -0,0 +1,283 @@
+#include "../include/TranspositionTable.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+const size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+const unsigned GENERATION_MASK = 63;
+// Plies of depth an entry is worth less per search since it was stored, for replacement
+const int AGE_PLIES = 8;
+
+// Data bits: score 0-31, move 32-44 (from 0-5, to 6-11, present 12), depth 48-55, bound 56-57,
+// generation 58-63. Squares are x * 8 + y.
+uint64_t packEntry(const TTEntry& entry, unsigned generation) {
+    uint64_t data = static_cast<uint32_t>(entry.score);
+    if (entry.move.first.first >= 0) {
+        uint64_t from = entry.move.first.first * 8 + entry.move.first.second;
+        uint64_t to = entry.move.second.first * 8 + entry.move.second.second;
+        data |= (1ull << 12 | to << 6 | from) << 32;
+    }
+    data |= static_cast<uint64_t>(std::max(0, std::min(entry.depth, 255))) << 48;
+    data |= static_cast<uint64_t>(entry.bound) << 56;
+    data |= static_cast<uint64_t>(generation & GENERATION_MASK) << 58;
+    return data;
+}
+
+void unpackEntry(uint64_t data, TTEntry& entry) {
+    entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+    unsigned move = data >> 32 & 0x1FFF;
+    if (move & 1 << 12) {
+        int from = move & 63, to = move >> 6 & 63;
+        entry.move = {{from / 8, from % 8}, {to / 8, to % 8}};
+    } else {
+        entry.move = {{-1, -1}, {-1, -1}};
+    }
+    entry.depth = data >> 48 & 255;
+    entry.bound = static_cast<TTBound>(data >> 56 & 3);
+}
+
+unsigned entryGeneration(uint64_t data) {
+    return static_cast<unsigned>(data >> 58);
+}
+
+// CPUs of each NUMA node that has any, from sysfs; empty where the OS does not say
+std::vector<std::vector<int>> numaNodeCpus() {
+    std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file.is_open()) {
+            break;
+        }
+        std::vector<int> cpus;
+        std::string range; // "N" or "N-M"
+        while (std::getline(file, range, ',')) {
+            int first = 0, last = 0;
+            int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields == 1) {
+                last = first;
+            }
+            for (int cpu = first; fields >= 1 && cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+#endif
+    return nodes;
+}
+
+// Restricts the calling thread to the given CPUs. Failure only costs memory locality.
+void pinThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+} // namespace
+
+bool TranspositionTable::resize(size_t megabytes, int threads) {
+    release();
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+        count *= 2;
+    }
+    size_t size = count * sizeof(Bucket);
+    
+    // Reserved huge pages first; otherwise ask for transparent ones on memory aligned to them
+    void* memory = nullptr;
+    pageMode = PageMode::NORMAL;
+#ifdef __linux__
+    if (size >= HUGE_PAGE_BYTES) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED) {
+            memory = nullptr;
+        } else {
+            pageMode = PageMode::HUGETLB;
+        }
+    }
+#endif
+    if (!memory) {
+#ifdef _WIN32
+        memory = _aligned_malloc(size, HUGE_PAGE_BYTES);
+#else
+        if (posix_memalign(&memory, HUGE_PAGE_BYTES, size) != 0) {
+            memory = nullptr;
+        }
+#endif
+#ifdef MADV_HUGEPAGE
+        if (memory && size >= HUGE_PAGE_BYTES && madvise(memory, size, MADV_HUGEPAGE) == 0) {
+            pageMode = PageMode::TRANSPARENT;
+        }
+#endif
+    }
+    if (!memory) {
+        std::cerr << "Error: Could not allocate a " << megabytes << " MB transposition table.\n";
+        return false;
+    }
+    
+    buckets = static_cast<Bucket*>(memory);
+    bucketMask = count - 1;
+    bytes = size;
+    clear(threads);
+    return true;
+}
+
+// The pages are not touched before this, so each lands on the node of the thread zeroing it
+void TranspositionTable::clear(int threads) {
+    if (!buckets) {
+        return;
+    }
+    std::vector<std::vector<int>> nodes = numaNodeCpus();
+    threads = std::max(1, threads);
+    size_t count = bucketMask + 1;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        size_t begin = count * i / threads;
+        size_t end = count * (i + 1) / threads;
+        workers.emplace_back([this, &nodes, threads, i, begin, end] {
+            if (threads > 1 && nodes.size() > 1) {
+                pinThread(nodes[i % nodes.size()]);
+            }
+            std::memset(static_cast<void*>(buckets + begin), 0, (end - begin) * sizeof(Bucket));
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    generation = 0;
+}
+
+const char* TranspositionTable::pageModeName() const {
+    switch (pageMode) {
+        case PageMode::HUGETLB: return "hugetlb";
+        case PageMode::TRANSPARENT: return "transparent";
+        default: return "normal";
+    }
+}
+
+void TranspositionTable::newSearch() {
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    if (!buckets) {
+        return false;
+    }
+    const Bucket& bucket = buckets[key & bucketMask];
+    for (const Slot& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (data && (slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            unpackEntry(data, entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Slots fill in order and are only emptied by clear(), so the first empty slot ends the search
+// for the key. Without one, the entry worth the fewest plies after ageing is replaced.
+bool TranspositionTable::store(uint64_t key, const TTEntry& entry) {
+    if (!buckets) {
+        return false;
+    }
+    unsigned current = generation.load(std::memory_order_relaxed);
+    Bucket& bucket = buckets[key & bucketMask];
+    Slot* target = nullptr;
+    bool replaced = false;
+    TTEntry stored = entry;
+    int lowest = INT_MAX;
+    for (Slot& slot : bucket.slots) {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        if (!data) {
+            target = &slot;
+            replaced = false;
+            break;
+        }
+        if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            if (stored.move.first.first < 0) {
+                TTEntry old;
+                unpackEntry(data, old);
+                stored.move = old.move;
+            }
+            target = &slot;
+            replaced = false;
+            break;
+        }
+        int age = static_cast<int>((current - entryGeneration(data)) & GENERATION_MASK);
+        int worth = static_cast<int>(data >> 48 & 255) - AGE_PLIES * age;
+        if (worth < lowest) {
+            lowest = worth;
+            target = &slot;
+            replaced = true;
+        }
+    }
+    
+    uint64_t data = packEntry(stored, current);
+    target->data.store(data, std::memory_order_relaxed);
+    target->check.store(key ^ data, std::memory_order_relaxed);
+    return replaced;
+}
+
+int TranspositionTable::hashfull() const {
+    if (!buckets) {
+        return 0;
+    }
+    unsigned current = generation.load(std::memory_order_relaxed) & GENERATION_MASK;
+    size_t samples = std::min<size_t>(1000 / TT_BUCKET_ENTRIES, bucketMask + 1);
+    size_t used = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        for (const Slot& slot : buckets[i].slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            used += data && entryGeneration(data) == current;
+        }
+    }
+    return static_cast<int>(used * 1000 / (samples * TT_BUCKET_ENTRIES));
+}
+
+void TranspositionTable::release() {
+    if (!buckets) {
+        return;
+    }
+#ifdef __linux__
+    if (pageMode == PageMode::HUGETLB) {
+        munmap(buckets, bytes);
+    } else {
+        std::free(buckets);
+    }
+#elif defined(_WIN32)
+    _aligned_free(buckets);
+#else
+    std::free(buckets);
+#endif
+    buckets = nullptr;
+    bucketMask = 0;
+    bytes = 0;
+}
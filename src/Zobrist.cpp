@@ -0,0 +1,67 @@
+#include "../include/Zobrist.h"
+#include "../include/Bitboard.h"
+
+namespace {
+
+struct ZobristKeys {
+    uint64_t piece[COLOR_COUNT][PIECE_TYPE_COUNT][64];
+    uint64_t castling[16];
+    uint64_t enPassant[8];
+    uint64_t side;
+
+    ZobristKeys() {
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (int c = 0; c < COLOR_COUNT; ++c) {
+            for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+                for (int square = 0; square < 64; ++square) {
+                    piece[c][t][square] = next(state);
+                }
+            }
+        }
+        
+        // Each right gets its own key; combinations are the XOR of their rights
+        uint64_t rightKeys[4];
+        for (int i = 0; i < 4; ++i) {
+            rightKeys[i] = next(state);
+        }
+        for (int rights = 0; rights < 16; ++rights) {
+            castling[rights] = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (rights & (1 << i)) castling[rights] ^= rightKeys[i];
+            }
+        }
+        
+        for (int file = 0; file < 8; ++file) {
+            enPassant[file] = next(state);
+        }
+        side = next(state);
+    }
+
+    // SplitMix64
+    static uint64_t next(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+const ZobristKeys KEYS;
+
+} // namespace
+
+uint64_t zobristPieceKey(int color, int type, int square) {
+    return KEYS.piece[color][type][square];
+}
+
+uint64_t zobristCastlingKey(int castlingRights) {
+    return KEYS.castling[castlingRights & 15];
+}
+
+uint64_t zobristEnPassantKey(int file) {
+    return KEYS.enPassant[file];
+}
+
+uint64_t zobristSideKey() {
+    return KEYS.side;
+}
@@ -1,8 +1,21 @@
 #include "../include/Game.h"
+#include "../include/Batch.h"
+#include "../include/Evaluation.h"
 #include <iostream>
 #include <string>
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (!loadStartupEvalParams()) {
+        return 1;
+    }
+    
+    // Non-interactive mode for scripts and data pipelines
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--batch") {
+            return runBatch(argc, argv);
+        }
+    }
+    
     std::cout << "=== CHESS GAME WITH AI ===\n\n";
     
     // Game mode selection
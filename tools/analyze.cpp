@@ -0,0 +1,349 @@
+// Annotates a PGN database with engine evaluations. Every move of every game is analysed on a
+// pool of worker threads: the position before the move is searched within the limits, then the
+// position after it one ply shallower, so both scores share a horizon. Each move gets a [%eval]
+// comment, and moves that lose at least the mistake or blunder threshold against the engine's
+// choice are marked "?" or "??" with the preferred move.
+// Games are written in input order while later games are still being analysed.
+// Usage: analyze [--threads N] [--nodes N] [--movetime ms] [--depth N]
+//                [--mistake pawns] [--blunder pawns] <input.pgn> [output.pgn]
+
+#include "../include/Evaluation.h"
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include "../include/PGN.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t DEFAULT_NODES = 50000;
+// Pawns lost by the move from the mover's point of view; a blunder is also a mistake
+const int DEFAULT_MISTAKE = 1;
+const int DEFAULT_BLUNDER = 3;
+
+struct Options {
+    int threads;
+    SearchLimits limits;
+    int mistake;
+    int blunder;
+    std::string input;
+    std::string output;
+};
+
+struct MoveAnalysis {
+    SearchResult best;   // Search of the position before the move
+    SearchResult played; // Search of the position after the move, one ply shallower
+};
+
+// A game in flight: the positions before and after each playable move, and their evaluations
+struct AnalysedGame {
+    PGNGame pgn;
+    std::vector<Game> positions;         // positions[i] is before move i; one extra after the last move
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> moves; // Replayed moves
+    std::vector<MoveAnalysis> analysis; // One per replayed move
+    size_t remaining;                    // Moves not yet analysed
+    std::string error;                   // Set if a move could not be replayed
+    int firstMoveNumber;
+};
+
+struct Task {
+    AnalysedGame* game;
+    size_t index;
+};
+
+// Work queue shared by the reader (main thread) and the workers
+struct Pipeline {
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable gameFinished;
+    std::deque<Task> tasks;
+    bool done = false;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.mistake = DEFAULT_MISTAKE;
+    options.blunder = DEFAULT_BLUNDER;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--nodes" && hasValue) {
+            options.limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--movetime" && hasValue) {
+            options.limits.movetimeMs = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            options.limits.depth = std::atoi(argv[++i]);
+        } else if (arg == "--mistake" && hasValue) {
+            options.mistake = std::atoi(argv[++i]);
+        } else if (arg == "--blunder" && hasValue) {
+            options.blunder = std::atoi(argv[++i]);
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else if (options.input.empty()) {
+            options.input = arg;
+        } else if (options.output.empty()) {
+            options.output = arg;
+        } else {
+            return false;
+        }
+    }
+    
+    if (!options.limits.depth && !options.limits.nodes && !options.limits.movetimeMs) {
+        options.limits.nodes = DEFAULT_NODES;
+    }
+    return !options.input.empty();
+}
+
+// Replays the movetext, keeping a snapshot of the game before every move
+void prepareGame(AnalysedGame& game) {
+    Game replay;
+    std::string fen = game.pgn.tag("FEN");
+    game.firstMoveNumber = 1;
+    if (!fen.empty()) {
+        if (!replay.setFEN(fen)) {
+            game.error = "invalid FEN tag";
+        }
+        std::istringstream fields(fen);
+        std::string field;
+        for (int i = 0; i < 6 && fields >> field; ++i) {
+            if (i == 5) game.firstMoveNumber = std::max(1, std::atoi(field.c_str()));
+        }
+    }
+    
+    game.positions.push_back(replay);
+    for (size_t i = 0; i < game.pgn.moves.size() && game.error.empty(); ++i) {
+        auto move = parseMove(replay.getBoard(), game.pgn.moves[i]);
+        if (!replay.applyMove(move.first.first, move.first.second, move.second.first, move.second.second)) {
+            game.error = "illegal move " + game.pgn.moves[i];
+            break;
+        }
+        game.moves.push_back(move);
+        game.positions.push_back(replay);
+    }
+    
+    game.analysis.resize(game.moves.size());
+    game.remaining = game.moves.size();
+}
+
+void worker(Pipeline& pipeline, const SearchLimits& limits) {
+    std::unique_lock<std::mutex> lock(pipeline.mutex);
+    while (true) {
+        pipeline.workAvailable.wait(lock, [&] { return !pipeline.tasks.empty() || pipeline.done; });
+        if (pipeline.tasks.empty()) {
+            return;
+        }
+        Task task = pipeline.tasks.front();
+        pipeline.tasks.pop_front();
+        lock.unlock();
+        
+        // Each task searches its own copies of the game, so workers share no search state
+        MoveAnalysis analysis;
+        analysis.best = task.game->positions[task.index].search(limits);
+        SearchLimits reply(std::max(1, analysis.best.depth - 1));
+        analysis.played = task.game->positions[task.index + 1].search(reply);
+        
+        lock.lock();
+        task.game->analysis[task.index] = analysis;
+        if (--task.game->remaining == 0) {
+            pipeline.gameFinished.notify_all();
+        }
+    }
+}
+
+// Mate scores are clamped so a slower mate does not count as a mistake
+int clampScore(int score) {
+    return std::max(-MATE_SCORE, std::min(MATE_SCORE, score));
+}
+
+std::string formatEval(const SearchResult& result) {
+    if (result.mateIn != 0) {
+        return "#" + std::to_string(result.mateIn);
+    }
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%.2f", result.score / 100.0);
+    return buffer;
+}
+
+std::string stripAnnotation(std::string move) {
+    while (!move.empty() && (move.back() == '!' || move.back() == '?')) {
+        move.pop_back();
+    }
+    return move;
+}
+
+// Writes one game with an eval comment after every move; returns the number of flagged moves
+int writeGame(std::ostream& out, const AnalysedGame& game, const Options& options) {
+    PGNGame pgn = game.pgn;
+    pgn.tags.push_back({"Annotator", "analyze"});
+    writePGNTags(out, pgn);
+    
+    std::string line;
+    int flagged = 0;
+    auto emit = [&](const std::string& text) {
+        if (!line.empty() && line.length() + 1 + text.length() > 79) {
+            out << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + text;
+    };
+    
+    size_t analysed = game.moves.size();
+    int firstPly = game.positions.front().isWhiteToMove() ? 0 : 1;
+    bool numberBlackMove = true; // Black moves are numbered at the start and after a comment
+    for (size_t i = 0; i < pgn.moves.size(); ++i) {
+        int ply = firstPly + static_cast<int>(i);
+        bool white = ply % 2 == 0;
+        if (white || numberBlackMove) {
+            emit(std::to_string(game.firstMoveNumber + ply / 2) + (white ? "." : "..."));
+        }
+        numberBlackMove = false;
+        
+        if (i >= analysed) {
+            emit(pgn.moves[i]); // Moves after a replay error are copied as they are
+            continue;
+        }
+        
+        const SearchResult& before = game.analysis[i].best;
+        const SearchResult& after = game.analysis[i].played;
+        int drop = clampScore(before.score) - clampScore(after.score); // Centipawns
+        if (!white) drop = -drop;
+        
+        // A mate or stalemate on the board has no evaluation to show
+        std::string move = stripAnnotation(pgn.moves[i]);
+        std::string comment;
+        if (after.bestMove.first.first != -1) {
+            comment = "[%eval " + formatEval(after) + "]";
+        }
+        if (drop >= options.mistake * 100 && before.bestMove != game.moves[i]) {
+            move += drop >= options.blunder * 100 ? "??" : "?";
+            const auto& best = before.bestMove;
+            comment += (comment.empty() ? "" : " ") + std::string("Best: ") +
+                       moveToNotation(best.first.first, best.first.second, best.second.first, best.second.second);
+            flagged++;
+        }
+        
+        emit(move);
+        if (!comment.empty()) {
+            emit("{ " + comment + " }");
+            numberBlackMove = true;
+        }
+    }
+    
+    emit(pgn.result.empty() ? "*" : pgn.result);
+    out << line << "\n\n";
+    return flagged;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: analyze [--threads N] [--nodes N] [--movetime ms] [--depth N]\n"
+                  << "               [--mistake pawns] [--blunder pawns] <input.pgn> [output.pgn]\n";
+        return 1;
+    }
+    if (!loadStartupEvalParams()) {
+        return 1;
+    }
+    
+    std::ifstream input(options.input);
+    if (!input.is_open()) {
+        std::cerr << "Error: Could not open file " << options.input << " for reading.\n";
+        return 1;
+    }
+    std::ofstream outputFile;
+    if (!options.output.empty()) {
+        outputFile.open(options.output);
+        if (!outputFile.is_open()) {
+            std::cerr << "Error: Could not open file " << options.output << " for writing.\n";
+            return 1;
+        }
+    }
+    std::ostream& output = options.output.empty() ? std::cout : outputFile;
+    
+    Pipeline pipeline;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.threads; ++i) {
+        workers.emplace_back(worker, std::ref(pipeline), std::cref(options.limits));
+    }
+    
+    // Games are read ahead of the writer, bounded so a large database is never fully in memory
+    const size_t maxGamesInFlight = 4 * static_cast<size_t>(options.threads);
+    std::deque<std::unique_ptr<AnalysedGame>> inFlight;
+    size_t games = 0, moves = 0;
+    int flagged = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    // Writes finished games from the front of the window; called with the lock held
+    auto flush = [&](std::unique_lock<std::mutex>& lock) {
+        while (!inFlight.empty() && inFlight.front()->remaining == 0) {
+            std::unique_ptr<AnalysedGame> game = std::move(inFlight.front());
+            inFlight.pop_front();
+            lock.unlock();
+            if (!game->error.empty()) {
+                std::cerr << "Game " << games + 1 << ": " << game->error << ", later moves not analysed\n";
+            }
+            flagged += writeGame(output, *game, options);
+            games++;
+            moves += game->moves.size();
+            lock.lock();
+        }
+    };
+    
+    PGNGame pgn;
+    while (readPGNGame(input, pgn)) {
+        std::unique_ptr<AnalysedGame> game(new AnalysedGame());
+        game->pgn = pgn;
+        prepareGame(*game);
+        
+        std::unique_lock<std::mutex> lock(pipeline.mutex);
+        for (size_t i = 0; i < game->moves.size(); ++i) {
+            pipeline.tasks.push_back({game.get(), i});
+        }
+        inFlight.push_back(std::move(game));
+        pipeline.workAvailable.notify_all();
+        
+        flush(lock);
+        while (inFlight.size() >= maxGamesInFlight) {
+            pipeline.gameFinished.wait(lock);
+            flush(lock);
+        }
+    }
+    
+    {
+        std::unique_lock<std::mutex> lock(pipeline.mutex);
+        pipeline.done = true;
+        pipeline.workAvailable.notify_all();
+        while (!inFlight.empty()) {
+            pipeline.gameFinished.wait(lock, [&] { return inFlight.front()->remaining == 0; });
+            flush(lock);
+        }
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Games: " << games << "\n"
+              << "Moves: " << moves << "\n"
+              << "Flagged moves: " << flagged << "\n"
+              << "Time: " << static_cast<int>(seconds * 1000) << " ms\n"
+              << "Moves/sec: " << static_cast<uint64_t>(seconds > 0 ? moves / seconds : 0) << "\n";
+    return 0;
+}
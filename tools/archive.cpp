@@ -0,0 +1,394 @@
+// Position and material search over a PGN archive.
+//
+// build: replays every game and writes an inverted index from position keys and material
+// signatures to the (game, ply) pairs where they occur (see Archive.h). The input files are cut
+// into shards that are replayed in parallel. Each worker collects postings, and spills them as
+// a sorted run file whenever they outgrow its memory budget. Game ids follow file order, so the
+// runs merge straight into the compressed posting lists.
+// find: lists the games where a position (FEN) or a material signature ("KRPvKR") occurred.
+// Usage: archive build [--threads N] [--shard-mb N] [--memory-mb N] <index> <games.pgn>...
+//        archive find [--limit N] <index> <fen | signature>
+
+#include "../include/Archive.h"
+#include "../include/Explorer.h"
+#include "../include/Notation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_SHARD_MB = 64;
+const int DEFAULT_MEMORY_MB = 256; // Per worker
+const size_t RUN_BUFFER_ENTRIES = 4096;
+const size_t DEFAULT_LIMIT = 20;
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct BuildOptions {
+    int threads = 1;
+    uint64_t shardBytes = DEFAULT_SHARD_MB * 1024ULL * 1024;
+    uint64_t memoryBytes = DEFAULT_MEMORY_MB * 1024ULL * 1024;
+    std::string index;
+    std::vector<std::string> inputs;
+};
+
+// One posting in a spilled run. Games are numbered within their shard until the merge.
+struct RunEntry {
+    uint64_t key;
+    uint32_t kind;
+    uint32_t shard;
+    uint32_t game;
+    uint32_t ply;
+};
+
+bool runEntryLess(const RunEntry& a, const RunEntry& b) {
+    if (a.kind != b.kind) return a.kind < b.kind;
+    if (a.key != b.key) return a.key < b.key;
+    if (a.shard != b.shard) return a.shard < b.shard;
+    if (a.game != b.game) return a.game < b.game;
+    return a.ply < b.ply;
+}
+
+// State shared by the build workers
+struct Build {
+    const BuildOptions& options;
+    std::vector<PGNShard> shards;
+    std::vector<uint32_t> shardFiles;             // Input file of each shard
+    std::vector<std::vector<ArchiveGame>> games;  // Per shard, written by the worker that owns it
+    std::atomic<size_t> nextShard{0};
+    std::atomic<uint64_t> illegalGames{0};        // Replay stopped at an illegal move or bad FEN
+    std::mutex mutex;                             // Guards runs
+    std::vector<std::string> runs;
+    
+    explicit Build(const BuildOptions& options) : options(options) {}
+};
+
+bool parseBuildOptions(int argc, char* argv[], BuildOptions& options) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--shard-mb" && hasValue) {
+            options.shardBytes = std::max(1, std::atoi(argv[++i])) * 1024ULL * 1024;
+        } else if (arg == "--memory-mb" && hasValue) {
+            options.memoryBytes = std::max(1, std::atoi(argv[++i])) * 1024ULL * 1024;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else if (options.index.empty()) {
+            options.index = arg;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.index.empty() && !options.inputs.empty();
+}
+
+// Replays a game, adding a posting for every position and for the first ply of every material
+// signature; returns false if the replay stopped before the end
+bool indexGame(const PGNGame& game, uint32_t shard, uint32_t gameIndex, std::vector<RunEntry>& entries,
+               uint32_t& plies) {
+    plies = 0;
+    Board board;
+    std::string fen = game.tag("FEN");
+    if (!fen.empty() && !board.loadFEN(fen)) {
+        return false;
+    }
+    
+    std::vector<uint64_t> materials; // Signatures already seen in this game
+    for (uint32_t ply = 0;; ++ply) {
+        entries.push_back({explorerKey(board), ARCHIVE_POSITION, shard, gameIndex, ply});
+        uint64_t material = materialKey(board);
+        if (std::find(materials.begin(), materials.end(), material) == materials.end()) {
+            materials.push_back(material);
+            entries.push_back({material, ARCHIVE_MATERIAL, shard, gameIndex, ply});
+        }
+        if (ply == game.moves.size()) {
+            return true;
+        }
+        
+        auto move = parseMove(board, game.moves[ply]);
+        if (move.first.first == -1) {
+            return false;
+        }
+        board.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+        plies = ply + 1;
+    }
+}
+
+// Writes the postings as a sorted run file and empties them
+bool spillRun(Build& build, std::vector<RunEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), runEntryLess);
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(build.mutex);
+        name = build.options.index + ".run" + std::to_string(build.runs.size());
+        build.runs.push_back(name);
+    }
+    std::ofstream out(name, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(RunEntry));
+    entries.clear();
+    if (!out) {
+        std::cerr << "Error: Could not write " << name << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void worker(Build& build, bool& failed) {
+    std::vector<RunEntry> entries;
+    size_t maxEntries = std::max<size_t>(1, build.options.memoryBytes / sizeof(RunEntry));
+    PGNGame game;
+    
+    for (size_t index = build.nextShard++; index < build.shards.size(); index = build.nextShard++) {
+        PGNShardReader reader;
+        if (!reader.open(build.shards[index])) {
+            continue;
+        }
+        
+        std::vector<ArchiveGame>& games = build.games[index];
+        uint64_t offset;
+        while (reader.next(game, offset)) {
+            ArchiveGame entry;
+            entry.offset = offset;
+            entry.file = build.shardFiles[index];
+            if (!indexGame(game, static_cast<uint32_t>(index), static_cast<uint32_t>(games.size()), entries, entry.plies)) {
+                build.illegalGames++;
+            }
+            games.push_back(entry);
+            if (entries.size() >= maxEntries && !spillRun(build, entries)) {
+                failed = true;
+                return;
+            }
+        }
+    }
+    
+    if (!entries.empty() && !spillRun(build, entries)) {
+        failed = true;
+    }
+}
+
+// Sequential reader of one run file
+class RunReader {
+public:
+    explicit RunReader(const std::string& name) : in(name, std::ios::binary), position(0) {
+        refill();
+    }
+    bool done() const { return position >= buffer.size(); }
+    const RunEntry& current() const { return buffer[position]; }
+    void next() {
+        if (++position >= buffer.size()) refill();
+    }
+
+private:
+    std::ifstream in;
+    std::vector<RunEntry> buffer;
+    size_t position;
+    
+    void refill() {
+        buffer.resize(RUN_BUFFER_ENTRIES);
+        in.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(RunEntry));
+        buffer.resize(static_cast<size_t>(in.gcount()) / sizeof(RunEntry));
+        position = 0;
+    }
+};
+
+// K-way merge of the sorted runs into one posting list per term, with global game ids
+void mergeRuns(const Build& build, const std::vector<uint32_t>& shardBase, ArchiveIndexWriter& writer) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const auto& name : build.runs) {
+        readers.emplace_back(new RunReader(name));
+    }
+    auto later = [&](size_t a, size_t b) { return runEntryLess(readers[b]->current(), readers[a]->current()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        if (!readers[i]->done()) heap.push(i);
+    }
+    
+    std::vector<ArchivePosting> postings;
+    uint32_t kind = 0;
+    uint64_t key = 0;
+    while (!heap.empty()) {
+        size_t index = heap.top();
+        heap.pop();
+        const RunEntry& entry = readers[index]->current();
+        if (!postings.empty() && (entry.kind != kind || entry.key != key)) {
+            writer.add(static_cast<ArchiveTermKind>(kind), key, postings);
+            postings.clear();
+        }
+        kind = entry.kind;
+        key = entry.key;
+        postings.push_back({shardBase[entry.shard] + entry.game, entry.ply});
+        
+        readers[index]->next();
+        if (!readers[index]->done()) heap.push(index);
+    }
+    if (!postings.empty()) {
+        writer.add(static_cast<ArchiveTermKind>(kind), key, postings);
+    }
+}
+
+int build(int argc, char* argv[]) {
+    BuildOptions options;
+    if (!parseBuildOptions(argc, argv, options)) {
+        std::cerr << "Usage: archive build [--threads N] [--shard-mb N] [--memory-mb N] <index> <games.pgn>...\n";
+        return 1;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    Build state(options);
+    for (size_t i = 0; i < options.inputs.size(); ++i) {
+        if (!splitPGNFile(options.inputs[i], options.shardBytes, state.shards)) {
+            return 1;
+        }
+        state.shardFiles.resize(state.shards.size(), static_cast<uint32_t>(i));
+    }
+    state.games.resize(state.shards.size());
+    
+    std::vector<std::thread> workers;
+    std::unique_ptr<bool[]> failed(new bool[options.threads]());
+    for (int i = 0; i < options.threads; ++i) {
+        workers.emplace_back(worker, std::ref(state), std::ref(failed[i]));
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    // Game ids follow the shards, which follow the files
+    std::vector<uint32_t> shardBase;
+    std::vector<ArchiveGame> games;
+    for (const auto& shardGames : state.games) {
+        shardBase.push_back(static_cast<uint32_t>(games.size()));
+        games.insert(games.end(), shardGames.begin(), shardGames.end());
+    }
+    
+    bool ok = std::none_of(failed.get(), failed.get() + options.threads, [](bool value) { return value; });
+    ArchiveIndexWriter writer;
+    if (ok && writer.open(options.index, options.inputs, games)) {
+        mergeRuns(state, shardBase, writer);
+        ok = writer.finish();
+    } else {
+        ok = false;
+    }
+    for (const auto& name : state.runs) {
+        std::remove(name.c_str());
+    }
+    if (!ok) {
+        return 1;
+    }
+    
+    ArchiveIndex index;
+    if (!index.open(options.index)) {
+        return 1;
+    }
+    const ArchiveHeader& header = index.getHeader();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Games: " << header.games << "\n"
+              << "Games with an illegal move: " << state.illegalGames << "\n"
+              << "Shards: " << state.shards.size() << ", runs: " << state.runs.size() << "\n"
+              << "Positions: " << header.positionTerms << "\n"
+              << "Material signatures: " << header.materialTerms << "\n"
+              << "Posting bytes: " << header.postingBytes << "\n"
+              << "Time: " << static_cast<int>(seconds * 1000) << " ms (merge "
+              << static_cast<int>((seconds - replaySeconds) * 1000) << " ms)\n"
+              << "Games/sec: " << static_cast<uint64_t>(seconds > 0 ? header.games / seconds : 0) << "\n";
+    return 0;
+}
+
+int find(int argc, char* argv[]) {
+    size_t limit = DEFAULT_LIMIT;
+    std::string indexFile, query;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--limit" && i + 1 < argc) {
+            limit = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (indexFile.empty()) {
+            indexFile = arg;
+        } else {
+            query += (query.empty() ? "" : " ") + arg;
+        }
+    }
+    if (indexFile.empty() || query.empty()) {
+        std::cerr << "Usage: archive find [--limit N] <index> <fen | signature>\n";
+        return 1;
+    }
+    
+    ArchiveIndex index;
+    if (!index.open(indexFile)) {
+        return 1;
+    }
+    
+    ArchiveTermKind kind;
+    uint64_t key;
+    if (query.find('/') == std::string::npos && parseMaterialSignature(query, key)) {
+        kind = ARCHIVE_MATERIAL;
+        query = materialSignature(key);
+    } else {
+        Board board;
+        if (!board.loadFEN(query == "startpos" ? START_FEN : query)) {
+            std::cerr << "Not a FEN or material signature: " << query << "\n";
+            return 1;
+        }
+        kind = ARCHIVE_POSITION;
+        key = explorerKey(board);
+    }
+    
+    // Every posting is decoded to count the distinct games
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ArchivePosting> postings;
+    uint64_t occurrences = index.find(kind, key, postings);
+    std::vector<ArchivePosting> firstPostings; // First occurrence in each game
+    for (const auto& posting : postings) {
+        if (firstPostings.empty() || firstPostings.back().game != posting.game) {
+            firstPostings.push_back(posting);
+        }
+    }
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    char time[32];
+    std::snprintf(time, sizeof(time), "%.2f", millis);
+    std::cout << query << ": " << firstPostings.size() << " games, " << occurrences << " occurrences ("
+              << time << " ms)\n";
+    for (size_t i = 0; i < firstPostings.size() && i < limit; ++i) {
+        const ArchivePosting& posting = firstPostings[i];
+        const ArchiveGame& game = index.getGame(posting.game);
+        PGNGame pgn;
+        std::string players = "?";
+        if (index.readGame(posting.game, pgn)) {
+            players = pgn.tag("White") + " - " + pgn.tag("Black") + "  " + pgn.tag("Event") + "  " + pgn.result;
+        }
+        std::cout << "  game " << posting.game << "  ply " << posting.ply << "  "
+                  << index.getFileName(game.file) << "@" << game.offset << "  " << players << "\n";
+    }
+    if (firstPostings.size() > limit) {
+        std::cout << "  ... " << firstPostings.size() - limit << " more (--limit)\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "build") {
+        return build(argc, argv);
+    }
+    if (command == "find") {
+        return find(argc, argv);
+    }
+    std::cerr << "Usage: archive build [--threads N] [--shard-mb N] [--memory-mb N] <index> <games.pgn>...\n"
+              << "       archive find [--limit N] <index> <fen | signature>\n";
+    return 1;
+}
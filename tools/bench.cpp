@@ -0,0 +1,47 @@
+// Fixed-depth search over a set of positions. Used as a quick speed check and as the
+// training workload for profile-guided builds.
+// Usage: bench [depth]
+
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+static const char* const BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N2N2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+int main(int argc, char* argv[]) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : 3;
+    if (depth < 1) depth = 1;
+    
+    double totalSeconds = 0;
+    int index = 1;
+    for (const char* fen : BENCH_POSITIONS) {
+        Game game;
+        if (!game.setFEN(fen)) {
+            std::cout << "Invalid FEN: " << fen << "\n";
+            return 1;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        auto move = game.getMinimaxMove(depth);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        totalSeconds += seconds;
+        
+        std::cout << "Position " << index++ << ": bestmove "
+                  << (move.first.first == -1 ? std::string("0000")
+                      : moveToNotation(move.first.first, move.first.second, move.second.first, move.second.second))
+                  << " (" << static_cast<int>(seconds * 1000) << " ms)\n";
+    }
+    
+    std::cout << "\nDepth: " << depth << "\n";
+    std::cout << "Total time (ms): " << static_cast<int>(totalSeconds * 1000) << "\n";
+    return 0;
+}
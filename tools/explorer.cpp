@@ -0,0 +1,392 @@
+// Opening explorer over a PGN database.
+//
+// build: replays the first plies of every game and writes an index from position to the moves
+// played there, with their results and average rating (see Explorer.h). The input files are cut
+// into shards at game boundaries, and the shards are indexed in parallel. Each worker counts
+// into a hash table that is spilled to a sorted run file when it grows past the memory budget;
+// the runs are merged into the index at the end, so the database never has to fit in memory.
+// query: prints the moves of positions given as FENs (or read from stdin, one per line).
+// Usage: explorer build [--plies N] [--threads N] [--shard-mb N] [--memory-mb N] <index> <games.pgn>...
+//        explorer query <index> [fen]
+
+#include "../include/Explorer.h"
+#include "../include/Notation.h"
+#include "../include/PGN.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_PLIES = 20;
+const int DEFAULT_SHARD_MB = 64;
+const int DEFAULT_MEMORY_MB = 256; // Per worker
+const size_t HASH_ENTRY_BYTES = 80; // Estimated size of one count in a worker's hash table
+const size_t RUN_BUFFER_ENTRIES = 4096;
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct BuildOptions {
+    int plies = DEFAULT_PLIES;
+    int threads = 1;
+    uint64_t shardBytes = DEFAULT_SHARD_MB * 1024ULL * 1024;
+    uint64_t memoryBytes = DEFAULT_MEMORY_MB * 1024ULL * 1024;
+    std::string index;
+    std::vector<std::string> inputs;
+};
+
+// One move count in a spilled run, ordered by position key and then move
+struct RunEntry {
+    uint64_t key;
+    ExplorerMoveRecord record;
+};
+
+bool runEntryLess(const RunEntry& a, const RunEntry& b) {
+    return a.key != b.key ? a.key < b.key : a.record.move < b.record.move;
+}
+
+struct EntryKey {
+    uint64_t key;
+    uint16_t move;
+    bool operator==(const EntryKey& other) const { return key == other.key && move == other.move; }
+};
+
+struct EntryKeyHash {
+    size_t operator()(const EntryKey& entry) const {
+        return static_cast<size_t>(entry.key ^ (static_cast<uint64_t>(entry.move) * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+// State shared by the build workers
+struct Build {
+    const BuildOptions& options;
+    std::vector<PGNShard> shards;
+    std::atomic<size_t> nextShard{0};
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> skippedGames{0}; // No result, or an illegal first move
+    std::mutex mutex;                      // Guards runs
+    std::vector<std::string> runs;
+    
+    explicit Build(const BuildOptions& options) : options(options) {}
+};
+
+bool parseBuildOptions(int argc, char* argv[], BuildOptions& options) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--plies" && hasValue) {
+            options.plies = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--shard-mb" && hasValue) {
+            options.shardBytes = std::max(1, std::atoi(argv[++i])) * 1024ULL * 1024;
+        } else if (arg == "--memory-mb" && hasValue) {
+            options.memoryBytes = std::max(1, std::atoi(argv[++i])) * 1024ULL * 1024;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else if (options.index.empty()) {
+            options.index = arg;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.index.empty() && !options.inputs.empty();
+}
+
+int parseResult(const std::string& result) {
+    if (result == "1-0") return 1;
+    if (result == "0-1") return -1;
+    if (result == "1/2-1/2") return 0;
+    return 2; // Unknown
+}
+
+// Counts the first plies of a game; returns false if it cannot be indexed
+bool indexGame(const PGNGame& game, int maxPlies,
+               std::unordered_map<EntryKey, ExplorerMoveRecord, EntryKeyHash>& counts) {
+    int result = parseResult(game.result.empty() ? game.tag("Result") : game.result);
+    if (result == 2) {
+        return false;
+    }
+    
+    Board board;
+    std::string fen = game.tag("FEN");
+    if (!fen.empty() && !board.loadFEN(fen)) {
+        return false;
+    }
+    int elo[2] = {std::atoi(game.tag("WhiteElo").c_str()), std::atoi(game.tag("BlackElo").c_str())};
+    
+    int plies = std::min<int>(maxPlies, static_cast<int>(game.moves.size()));
+    for (int ply = 0; ply < plies; ++ply) {
+        auto move = parseMove(board, game.moves[ply]);
+        if (move.first.first == -1) {
+            return ply > 0; // The plies before an illegal move still count
+        }
+        
+        bool white = board.isWhiteToMove();
+        int moverResult = white ? result : -result;
+        int rating = elo[white ? 0 : 1];
+        ExplorerMoveRecord& record = counts[{explorerKey(board), explorerMoveCode(move)}];
+        record.move = explorerMoveCode(move);
+        record.games++;
+        record.wins += moverResult > 0;
+        record.draws += moverResult == 0;
+        record.losses += moverResult < 0;
+        if (rating > 0) {
+            record.ratedGames++;
+            record.ratingSum += static_cast<uint64_t>(rating);
+        }
+        board.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+    }
+    return true;
+}
+
+// Writes the counts as a sorted run file and empties the table
+bool spillRun(Build& build, std::unordered_map<EntryKey, ExplorerMoveRecord, EntryKeyHash>& counts) {
+    std::vector<RunEntry> entries;
+    entries.reserve(counts.size());
+    for (const auto& count : counts) {
+        entries.push_back({count.first.key, count.second});
+    }
+    counts.clear();
+    std::sort(entries.begin(), entries.end(), runEntryLess);
+    
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(build.mutex);
+        name = build.options.index + ".run" + std::to_string(build.runs.size());
+        build.runs.push_back(name);
+    }
+    std::ofstream out(name, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(RunEntry));
+    if (!out) {
+        std::cerr << "Error: Could not write " << name << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void worker(Build& build, bool& failed) {
+    std::unordered_map<EntryKey, ExplorerMoveRecord, EntryKeyHash> counts;
+    size_t maxEntries = std::max<size_t>(1, build.options.memoryBytes / HASH_ENTRY_BYTES);
+    PGNGame game;
+    
+    for (size_t index = build.nextShard++; index < build.shards.size(); index = build.nextShard++) {
+        PGNShardReader reader;
+        if (!reader.open(build.shards[index])) {
+            continue;
+        }
+        
+        uint64_t games = 0, skipped = 0, offset;
+        while (reader.next(game, offset)) {
+            if (indexGame(game, build.options.plies, counts)) {
+                games++;
+            } else {
+                skipped++;
+            }
+            if (counts.size() >= maxEntries && !spillRun(build, counts)) {
+                failed = true;
+                return;
+            }
+        }
+        build.games += games;
+        build.skippedGames += skipped;
+    }
+    
+    if (!counts.empty() && !spillRun(build, counts)) {
+        failed = true;
+    }
+}
+
+// Sequential reader of one run file
+class RunReader {
+public:
+    explicit RunReader(const std::string& name) : in(name, std::ios::binary), position(0) {
+        refill();
+    }
+    bool done() const { return position >= buffer.size(); }
+    const RunEntry& current() const { return buffer[position]; }
+    void next() {
+        if (++position >= buffer.size()) refill();
+    }
+
+private:
+    std::ifstream in;
+    std::vector<RunEntry> buffer;
+    size_t position;
+    
+    void refill() {
+        buffer.resize(RUN_BUFFER_ENTRIES);
+        in.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(RunEntry));
+        buffer.resize(static_cast<size_t>(in.gcount()) / sizeof(RunEntry));
+        position = 0;
+    }
+};
+
+// K-way merge of the sorted runs, summing the counts of each position and move
+bool mergeRuns(const Build& build, ExplorerIndexWriter& writer) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const auto& name : build.runs) {
+        readers.emplace_back(new RunReader(name));
+    }
+    auto later = [&](size_t a, size_t b) { return runEntryLess(readers[b]->current(), readers[a]->current()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        if (!readers[i]->done()) heap.push(i);
+    }
+    
+    std::vector<ExplorerMoveRecord> moves;
+    uint64_t key = 0;
+    while (!heap.empty()) {
+        size_t index = heap.top();
+        heap.pop();
+        const RunEntry& entry = readers[index]->current();
+        if (!moves.empty() && entry.key != key) {
+            writer.add(key, moves);
+            moves.clear();
+        }
+        key = entry.key;
+        if (!moves.empty() && moves.back().move == entry.record.move) {
+            moves.back().add(entry.record);
+        } else {
+            moves.push_back(entry.record);
+        }
+        
+        readers[index]->next();
+        if (!readers[index]->done()) heap.push(index);
+    }
+    if (!moves.empty()) {
+        writer.add(key, moves);
+    }
+    return true;
+}
+
+int build(int argc, char* argv[]) {
+    BuildOptions options;
+    if (!parseBuildOptions(argc, argv, options)) {
+        std::cerr << "Usage: explorer build [--plies N] [--threads N] [--shard-mb N] [--memory-mb N]"
+                  << " <index> <games.pgn>...\n";
+        return 1;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    Build state(options);
+    for (const auto& input : options.inputs) {
+        if (!splitPGNFile(input, options.shardBytes, state.shards)) {
+            return 1;
+        }
+    }
+    
+    std::vector<std::thread> workers;
+    std::unique_ptr<bool[]> failed(new bool[options.threads]());
+    for (int i = 0; i < options.threads; ++i) {
+        workers.emplace_back(worker, std::ref(state), std::ref(failed[i]));
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    double indexSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    bool ok = std::none_of(failed.get(), failed.get() + options.threads, [](bool value) { return value; });
+    ExplorerIndexWriter writer;
+    ok = ok && writer.open(options.index, static_cast<uint32_t>(options.plies)) &&
+         mergeRuns(state, writer) && writer.finish(state.games);
+    for (const auto& name : state.runs) {
+        std::remove(name.c_str());
+    }
+    if (!ok) {
+        return 1;
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Games: " << state.games << "\n"
+              << "Skipped games: " << state.skippedGames << "\n"
+              << "Shards: " << state.shards.size() << ", runs: " << state.runs.size() << "\n"
+              << "Positions: " << writer.getPositionCount() << "\n"
+              << "Moves: " << writer.getMoveCount() << "\n"
+              << "Time: " << static_cast<int>(seconds * 1000) << " ms (merge "
+              << static_cast<int>((seconds - indexSeconds) * 1000) << " ms)\n"
+              << "Games/sec: " << static_cast<uint64_t>(seconds > 0 ? state.games / seconds : 0) << "\n";
+    return 0;
+}
+
+void printMoves(const ExplorerIndex& index, const std::string& fen) {
+    std::vector<ExplorerMove> moves;
+    auto start = std::chrono::steady_clock::now();
+    bool valid = index.query(fen, moves);
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (!valid) {
+        std::cout << "Invalid FEN: " << fen << "\n";
+        return;
+    }
+    
+    Board board;
+    board.loadFEN(fen);
+    uint64_t games = 0;
+    for (const auto& move : moves) {
+        games += move.games;
+    }
+    std::cout << fen << "\n";
+    for (const auto& move : moves) {
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-7s %10u %6.1f%% win %6.1f%% draw %6.1f%% loss  avg %4.0f\n",
+                      moveToSAN(board, move.move).c_str(), move.games, 100.0 * move.wins / move.games,
+                      100.0 * move.draws / move.games, 100.0 * move.losses / move.games, move.averageRating);
+        std::cout << line;
+    }
+    char summary[64];
+    std::snprintf(summary, sizeof(summary), "%.1f", micros);
+    std::cout << "  " << games << " games, " << moves.size() << " moves, query " << summary << " us\n";
+}
+
+int query(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: explorer query <index> [fen]\n";
+        return 1;
+    }
+    ExplorerIndex index;
+    if (!index.open(argv[2])) {
+        return 1;
+    }
+    
+    if (argc > 3) {
+        std::string fen;
+        for (int i = 3; i < argc; ++i) {
+            fen += (i > 3 ? " " : "") + std::string(argv[i]);
+        }
+        printMoves(index, fen == "startpos" ? START_FEN : fen);
+        return 0;
+    }
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty()) {
+            printMoves(index, line == "startpos" ? START_FEN : line);
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "build") {
+        return build(argc, argv);
+    }
+    if (command == "query") {
+        return query(argc, argv);
+    }
+    std::cerr << "Usage: explorer build [--plies N] [--threads N] [--shard-mb N] [--memory-mb N] <index> <games.pgn>...\n"
+              << "       explorer query <index> [fen]\n";
+    return 1;
+}
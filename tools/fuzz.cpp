@@ -0,0 +1,610 @@
+// Differential fuzzer for the rules. Plays random legal games on Board and on a plain 8x8
+// reference board written here straight from the rules, the way the original Piece-class board
+// worked: moves are checked square by square, and a move is legal if the king is not attacked once
+// it is made on a copy. After every move it compares the legal move sets, the FEN, check,
+// checkmate and stalemate, and the Zobrist keys (incremental, recomputed and after a FEN round
+// trip). Board::isValidMove, Board::getLegalMoves and the Piece classes' isValidMove are checked
+// against the same move set. Castling, en passant, promotions and double pawn pushes are played
+// more often than chance would, since they are the moves with special-cased code.
+// Usage: fuzz [--games N] [--plies N] [--seed N] [fen]
+//
+// Configured with -DCHESS_LIBFUZZER=ON (Clang), this is a libFuzzer target instead: the first
+// input byte picks the start position and each further byte the next move.
+
+#include "../include/Board.h"
+#include "../include/Notation.h"
+#include "../include/Zobrist.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_GAMES = 1000;
+const int DEFAULT_MAX_PLIES = 300;
+
+// The initial position and the perft positions that exercise castling, en passant and promotion
+const char* const START_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+    "8/8/8/KPp4r/8/8/8/7k w - c6 0 2",
+};
+const int NUM_START_POSITIONS = sizeof(START_POSITIONS) / sizeof(START_POSITIONS[0]);
+
+typedef std::pair<std::pair<int, int>, std::pair<int, int>> FuzzMove;
+
+const char* const PIECE_LETTERS = "PNBRQK"; // Index is the PieceType
+
+bool isWhitePiece(char piece) {
+    return piece >= 'A' && piece <= 'Z';
+}
+
+bool onBoard(int x, int y) {
+    return x >= 0 && x < 8 && y >= 0 && y < 8;
+}
+
+// Castling rights lost when a piece leaves or arrives on a square
+int castlingRightsOfSquare(int x, int y) {
+    if (x == 7 && y == 4) return WHITE_KINGSIDE | WHITE_QUEENSIDE;
+    if (x == 7 && y == 7) return WHITE_KINGSIDE;
+    if (x == 7 && y == 0) return WHITE_QUEENSIDE;
+    if (x == 0 && y == 4) return BLACK_KINGSIDE | BLACK_QUEENSIDE;
+    if (x == 0 && y == 7) return BLACK_KINGSIDE;
+    if (x == 0 && y == 0) return BLACK_QUEENSIDE;
+    return 0;
+}
+
+// Mailbox board with no shared code with Board beyond the Zobrist keys. Pieces are FEN symbols.
+// Like Board, it keeps the en passant target after every double push and promotes to a queen.
+class ReferenceBoard {
+public:
+    bool loadFEN(const std::string& fen);
+    std::string toFEN() const;
+    uint64_t zobristKey() const;
+    
+    bool isWhiteToMove() const { return whiteToMove; }
+    char at(int x, int y) const { return squares[x][y]; }
+    bool inCheck() const;
+    std::vector<FuzzMove> legalMoves() const; // Sorted
+    void makeMove(const FuzzMove& move);
+
+private:
+    char squares[8][8]; // '.' if empty
+    bool whiteToMove;
+    int castlingRights;
+    int enPassantX, enPassantY; // -1 if none
+    int halfmoveClock;
+    int fullmoveNumber;
+    
+    bool isOwn(int x, int y, bool white) const {
+        return squares[x][y] != '.' && isWhitePiece(squares[x][y]) == white;
+    }
+    bool isAttacked(int x, int y, bool byWhite) const;
+    void addPseudoLegalMoves(int x, int y, std::vector<FuzzMove>& moves) const;
+};
+
+bool ReferenceBoard::loadFEN(const std::string& fen) {
+    std::istringstream iss(fen);
+    std::string placement, side, castling = "-", enPassant = "-";
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    if (!(iss >> placement >> side) || (side != "w" && side != "b")) {
+        return false;
+    }
+    iss >> castling >> enPassant >> halfmoveClock >> fullmoveNumber;
+    
+    int x = 0, y = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (y != 8 || ++x > 7) return false;
+            y = 0;
+        } else if (c >= '1' && c <= '8') {
+            for (int i = 0; i < c - '0'; ++i) {
+                if (y > 7) return false;
+                squares[x][y++] = '.';
+            }
+        } else if (std::string("PNBRQKpnbrqk").find(c) != std::string::npos && y < 8) {
+            squares[x][y++] = c;
+        } else {
+            return false;
+        }
+    }
+    if (x != 7 || y != 8) {
+        return false;
+    }
+    
+    whiteToMove = side == "w";
+    castlingRights = 0;
+    if (castling.find('K') != std::string::npos) castlingRights |= WHITE_KINGSIDE;
+    if (castling.find('Q') != std::string::npos) castlingRights |= WHITE_QUEENSIDE;
+    if (castling.find('k') != std::string::npos) castlingRights |= BLACK_KINGSIDE;
+    if (castling.find('q') != std::string::npos) castlingRights |= BLACK_QUEENSIDE;
+    enPassantX = enPassantY = -1;
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' &&
+        (enPassant[1] == '3' || enPassant[1] == '6')) {
+        enPassantX = '8' - enPassant[1];
+        enPassantY = enPassant[0] - 'a';
+    }
+    return true;
+}
+
+std::string ReferenceBoard::toFEN() const {
+    std::string fen;
+    for (int x = 0; x < 8; ++x) {
+        int empty = 0;
+        for (int y = 0; y < 8; ++y) {
+            if (squares[x][y] == '.') {
+                empty++;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += squares[x][y];
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (x < 7) fen += '/';
+    }
+    fen += whiteToMove ? " w " : " b ";
+    if (castlingRights & WHITE_KINGSIDE) fen += 'K';
+    if (castlingRights & WHITE_QUEENSIDE) fen += 'Q';
+    if (castlingRights & BLACK_KINGSIDE) fen += 'k';
+    if (castlingRights & BLACK_QUEENSIDE) fen += 'q';
+    if (!castlingRights) fen += '-';
+    fen += ' ';
+    fen += enPassantX < 0 ? "-" : squareToNotation(enPassantX, enPassantY);
+    return fen + " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+}
+
+uint64_t ReferenceBoard::zobristKey() const {
+    uint64_t key = 0;
+    for (int x = 0; x < 8; ++x) {
+        for (int y = 0; y < 8; ++y) {
+            char piece = squares[x][y];
+            if (piece != '.') {
+                int type = static_cast<int>(std::string(PIECE_LETTERS).find(static_cast<char>(std::toupper(piece))));
+                key ^= zobristPieceKey(isWhitePiece(piece) ? WHITE : BLACK, type, x * 8 + y);
+            }
+        }
+    }
+    key ^= zobristCastlingKey(castlingRights);
+    if (enPassantX >= 0) key ^= zobristEnPassantKey(enPassantY);
+    if (!whiteToMove) key ^= zobristSideKey();
+    return key;
+}
+
+bool ReferenceBoard::isAttacked(int x, int y, bool byWhite) const {
+    // Looking outwards from the square: a white pawn attacks from the row below it (higher x)
+    int pawnRow = byWhite ? x + 1 : x - 1;
+    char pawn = byWhite ? 'P' : 'p';
+    for (int dy = -1; dy <= 1; dy += 2) {
+        if (onBoard(pawnRow, y + dy) && squares[pawnRow][y + dy] == pawn) return true;
+    }
+    
+    const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+    char knight = byWhite ? 'N' : 'n';
+    for (const auto& step : knightSteps) {
+        int tx = x + step[0], ty = y + step[1];
+        if (onBoard(tx, ty) && squares[tx][ty] == knight) return true;
+    }
+    
+    char king = byWhite ? 'K' : 'k';
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            if ((dx || dy) && onBoard(x + dx, y + dy) && squares[x + dx][y + dy] == king) return true;
+        }
+    }
+    
+    // Sliders: the first piece along each line
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            if (!dx && !dy) continue;
+            bool diagonal = dx && dy;
+            int tx = x + dx, ty = y + dy;
+            while (onBoard(tx, ty) && squares[tx][ty] == '.') {
+                tx += dx;
+                ty += dy;
+            }
+            if (!onBoard(tx, ty) || isWhitePiece(squares[tx][ty]) != byWhite) continue;
+            char type = static_cast<char>(std::toupper(squares[tx][ty]));
+            if (type == 'Q' || type == (diagonal ? 'B' : 'R')) return true;
+        }
+    }
+    return false;
+}
+
+bool ReferenceBoard::inCheck() const {
+    char king = whiteToMove ? 'K' : 'k';
+    for (int x = 0; x < 8; ++x) {
+        for (int y = 0; y < 8; ++y) {
+            if (squares[x][y] == king) return isAttacked(x, y, !whiteToMove);
+        }
+    }
+    return false;
+}
+
+void ReferenceBoard::addPseudoLegalMoves(int x, int y, std::vector<FuzzMove>& moves) const {
+    bool white = isWhitePiece(squares[x][y]);
+    char type = static_cast<char>(std::toupper(squares[x][y]));
+    auto add = [&](int tx, int ty) { moves.push_back({{x, y}, {tx, ty}}); };
+    
+    if (type == 'P') {
+        int dir = white ? -1 : 1;
+        if (onBoard(x + dir, y) && squares[x + dir][y] == '.') {
+            add(x + dir, y);
+            if (x == (white ? 6 : 1) && squares[x + 2 * dir][y] == '.') add(x + 2 * dir, y);
+        }
+        for (int dy = -1; dy <= 1; dy += 2) {
+            int tx = x + dir, ty = y + dy;
+            if (!onBoard(tx, ty)) continue;
+            if (squares[tx][ty] != '.' && !isOwn(tx, ty, white)) {
+                add(tx, ty);
+            } else if (tx == enPassantX && ty == enPassantY && squares[tx][ty] == '.' &&
+                       squares[x][ty] == (white ? 'p' : 'P')) {
+                add(tx, ty);
+            }
+        }
+        return;
+    }
+    
+    if (type == 'N' || type == 'K') {
+        const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+        const int kingSteps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+        for (const auto& step : type == 'N' ? knightSteps : kingSteps) {
+            int tx = x + step[0], ty = y + step[1];
+            if (onBoard(tx, ty) && !isOwn(tx, ty, white)) add(tx, ty);
+        }
+    } else {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                bool diagonal = dx && dy;
+                if ((!dx && !dy) || (type == 'B' && !diagonal) || (type == 'R' && diagonal)) continue;
+                for (int tx = x + dx, ty = y + dy; onBoard(tx, ty) && !isOwn(tx, ty, white); tx += dx, ty += dy) {
+                    add(tx, ty);
+                    if (squares[tx][ty] != '.') break;
+                }
+            }
+        }
+    }
+    
+    // Castling: the right, king and rook in place, the squares between empty, and the king not in,
+    // through or into check
+    int row = white ? 7 : 0;
+    if (type != 'K' || x != row || y != 4) {
+        return;
+    }
+    char rook = white ? 'R' : 'r';
+    for (int side = 0; side < 2; ++side) {
+        bool kingside = side == 0;
+        int right = white ? (kingside ? WHITE_KINGSIDE : WHITE_QUEENSIDE) : (kingside ? BLACK_KINGSIDE : BLACK_QUEENSIDE);
+        int rookY = kingside ? 7 : 0;
+        int step = kingside ? 1 : -1;
+        if (!(castlingRights & right) || squares[row][rookY] != rook) continue;
+        bool clear = true;
+        for (int ty = 4 + step; ty != rookY; ty += step) {
+            clear = clear && squares[row][ty] == '.';
+        }
+        if (clear && !isAttacked(row, 4, !white) && !isAttacked(row, 4 + step, !white) &&
+            !isAttacked(row, 4 + 2 * step, !white)) {
+            add(row, 4 + 2 * step);
+        }
+    }
+}
+
+std::vector<FuzzMove> ReferenceBoard::legalMoves() const {
+    std::vector<FuzzMove> pseudoLegal, legal;
+    for (int x = 0; x < 8; ++x) {
+        for (int y = 0; y < 8; ++y) {
+            if (isOwn(x, y, whiteToMove)) addPseudoLegalMoves(x, y, pseudoLegal);
+        }
+    }
+    for (const FuzzMove& move : pseudoLegal) {
+        ReferenceBoard after = *this;
+        after.makeMove(move);
+        after.whiteToMove = whiteToMove;
+        if (!after.inCheck()) legal.push_back(move);
+    }
+    std::sort(legal.begin(), legal.end());
+    return legal;
+}
+
+void ReferenceBoard::makeMove(const FuzzMove& move) {
+    int x1 = move.first.first, y1 = move.first.second;
+    int x2 = move.second.first, y2 = move.second.second;
+    char piece = squares[x1][y1];
+    char type = static_cast<char>(std::toupper(piece));
+    bool capture = squares[x2][y2] != '.';
+    
+    if (type == 'P' && y1 != y2 && !capture) {
+        squares[x1][y2] = '.'; // En passant
+        capture = true;
+    }
+    if (type == 'K' && std::abs(y2 - y1) == 2) {
+        int rookFrom = y2 > y1 ? 7 : 0, rookTo = y2 > y1 ? 5 : 3;
+        squares[x1][rookTo] = squares[x1][rookFrom];
+        squares[x1][rookFrom] = '.';
+    }
+    squares[x2][y2] = type == 'P' && (x2 == 0 || x2 == 7) ? (isWhitePiece(piece) ? 'Q' : 'q') : piece;
+    squares[x1][y1] = '.';
+    
+    castlingRights &= ~(castlingRightsOfSquare(x1, y1) | castlingRightsOfSquare(x2, y2));
+    enPassantX = enPassantY = -1;
+    if (type == 'P' && std::abs(x2 - x1) == 2) {
+        enPassantX = (x1 + x2) / 2;
+        enPassantY = y1;
+    }
+    halfmoveClock = type == 'P' || capture ? 0 : halfmoveClock + 1;
+    if (!whiteToMove) fullmoveNumber++;
+    whiteToMove = !whiteToMove;
+}
+
+// FEN of a Board from its accessors; Board has no move number, so the caller supplies it
+std::string boardFEN(const Board& board, int fullmoveNumber) {
+    std::string fen;
+    for (int x = 0; x < 8; ++x) {
+        int empty = 0;
+        for (int y = 0; y < 8; ++y) {
+            PieceCode code = board.getPieceCode(x, y);
+            if (!code) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += pieceCodeSymbol(code);
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (x < 7) fen += '/';
+    }
+    fen += board.isWhiteToMove() ? " w " : " b ";
+    int rights = board.getCastlingRights();
+    if (rights & WHITE_KINGSIDE) fen += 'K';
+    if (rights & WHITE_QUEENSIDE) fen += 'Q';
+    if (rights & BLACK_KINGSIDE) fen += 'k';
+    if (rights & BLACK_QUEENSIDE) fen += 'q';
+    if (!rights) fen += '-';
+    fen += ' ';
+    std::pair<int, int> target = board.getEnPassantTarget();
+    fen += target.first < 0 ? "-" : squareToNotation(target.first, target.second);
+    return fen + " " + std::to_string(board.getHalfmoveClock()) + " " + std::to_string(fullmoveNumber);
+}
+
+std::string movesToString(const std::vector<FuzzMove>& moves) {
+    std::string text;
+    for (const FuzzMove& move : moves) {
+        text += " " + moveToNotation(move.first.first, move.first.second, move.second.first, move.second.second);
+    }
+    return text.empty() ? " (none)" : text;
+}
+
+std::string hexKey(uint64_t key) {
+    std::ostringstream oss;
+    oss << std::hex << key;
+    return oss.str();
+}
+
+// Compares the boards; returns the first difference found, or "" if there is none
+std::string compareBoards(const Board& board, const ReferenceBoard& reference, const std::vector<FuzzMove>& legal) {
+    std::string fen = reference.toFEN();
+    int fullmove = std::atoi(fen.substr(fen.rfind(' ') + 1).c_str());
+    if (boardFEN(board, fullmove) != fen) {
+        return "FEN differs";
+    }
+    
+    uint64_t key = reference.zobristKey();
+    if (board.getZobristKey() != key) {
+        return "Zobrist key " + hexKey(board.getZobristKey()) + ", expected " + hexKey(key);
+    }
+    if (board.computeZobristKey() != key) {
+        return "recomputed Zobrist key " + hexKey(board.computeZobristKey()) + ", expected " + hexKey(key);
+    }
+    Board loaded;
+    if (!loaded.loadFEN(fen) || loaded.getZobristKey() != key || boardFEN(loaded, fullmove) != fen) {
+        return "Board::loadFEN of the reference FEN gives a different position or key";
+    }
+    
+    bool white = board.isWhiteToMove();
+    std::vector<FuzzMove> generated;
+    board.generateLegalMoves(white, generated);
+    std::sort(generated.begin(), generated.end());
+    if (generated != legal) {
+        std::vector<FuzzMove> missing, extra;
+        std::set_difference(legal.begin(), legal.end(), generated.begin(), generated.end(), std::back_inserter(missing));
+        std::set_difference(generated.begin(), generated.end(), legal.begin(), legal.end(), std::back_inserter(extra));
+        return "generateLegalMoves is missing" + movesToString(missing) + "; has extra" + movesToString(extra);
+    }
+    
+    // Per-square move lists and move checks, including the legacy Piece classes, which accept
+    // every legal move (they do not look at pins)
+    for (int x = 0; x < 8; ++x) {
+        for (int y = 0; y < 8; ++y) {
+            Piece* piece = board.getPiece(x, y);
+            if (!piece || piece->isWhite() != white) continue;
+            std::vector<std::pair<int, int>> targets = board.getLegalMoves(x, y);
+            std::sort(targets.begin(), targets.end());
+            for (int tx = 0; tx < 8; ++tx) {
+                for (int ty = 0; ty < 8; ++ty) {
+                    FuzzMove move = {{x, y}, {tx, ty}};
+                    bool isLegal = std::binary_search(legal.begin(), legal.end(), move);
+                    std::string name = moveToNotation(x, y, tx, ty);
+                    if (board.isValidMove(x, y, tx, ty) != isLegal) {
+                        return "Board::isValidMove(" + name + ") is " + (isLegal ? "false" : "true");
+                    }
+                    if (std::binary_search(targets.begin(), targets.end(), std::make_pair(tx, ty)) != isLegal) {
+                        return "Board::getLegalMoves " + std::string(isLegal ? "is missing " : "has extra ") + name;
+                    }
+                    if (isLegal && !piece->isValidMove(x, y, tx, ty, board)) {
+                        return std::string(1, piece->getSymbol()) + "::isValidMove rejects legal " + name;
+                    }
+                }
+            }
+        }
+    }
+    
+    bool check = reference.inCheck();
+    bool mated = check && legal.empty();
+    bool stalemated = !check && legal.empty();
+    if (board.isCheck(white) != check || board.isCheckmate(white) != mated ||
+        board.isStalemate(white) != stalemated || board.hasLegalMoves(white) == legal.empty()) {
+        return std::string("check/checkmate/stalemate state differs: expected ") +
+               (mated ? "checkmate" : stalemated ? "stalemate" : check ? "check" : "none");
+    }
+    return "";
+}
+
+struct FuzzTotals {
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    uint64_t castles = 0;
+    uint64_t enPassants = 0;
+    uint64_t promotions = 0;
+    uint64_t checkmates = 0;
+    uint64_t stalemates = 0;
+};
+
+bool isSpecialMove(const ReferenceBoard& reference, const FuzzMove& move) {
+    char type = static_cast<char>(std::toupper(reference.at(move.first.first, move.first.second)));
+    int dx = std::abs(move.second.first - move.first.first);
+    int dy = std::abs(move.second.second - move.first.second);
+    bool enPassant = dy == 1 && reference.at(move.second.first, move.second.second) == '.';
+    return (type == 'K' && dy == 2) ||
+           (type == 'P' && (dx == 2 || enPassant || move.second.first == 0 || move.second.first == 7));
+}
+
+// Plays from the FEN until the game ends, maxPlies or choose(legal moves) returns -1. Prints the
+// game and returns false at the first difference between the boards.
+template <typename Chooser>
+bool playGame(const std::string& fen, int maxPlies, Chooser choose, FuzzTotals& totals) {
+    Board board;
+    ReferenceBoard reference;
+    if (!board.loadFEN(fen) || !reference.loadFEN(fen)) {
+        std::cerr << "Error: Invalid FEN: " << fen << "\n";
+        return false;
+    }
+    totals.games++;
+    
+    std::vector<FuzzMove> played;
+    for (int ply = 0;; ++ply) {
+        std::vector<FuzzMove> legal = reference.legalMoves();
+        std::string difference = compareBoards(board, reference, legal);
+        if (!difference.empty()) {
+            std::string referenceFEN = reference.toFEN();
+            int fullmove = std::atoi(referenceFEN.substr(referenceFEN.rfind(' ') + 1).c_str());
+            std::cout << "Mismatch: " << difference << "\n"
+                      << "  Start:     " << fen << "\n"
+                      << "  Moves:    " << movesToString(played) << "\n"
+                      << "  Board:     " << boardFEN(board, fullmove) << "\n"
+                      << "  Reference: " << referenceFEN << "\n"
+                      << "  Legal:    " << movesToString(legal) << "\n";
+            return false;
+        }
+        if (legal.empty()) {
+            (reference.inCheck() ? totals.checkmates : totals.stalemates)++;
+            return true;
+        }
+        int index = ply < maxPlies ? choose(reference, legal) : -1;
+        if (index < 0) {
+            return true;
+        }
+        
+        const FuzzMove& move = legal[index];
+        int x1 = move.first.first, y1 = move.first.second, x2 = move.second.first, y2 = move.second.second;
+        char type = static_cast<char>(std::toupper(reference.at(x1, y1)));
+        totals.castles += type == 'K' && std::abs(y2 - y1) == 2;
+        totals.enPassants += type == 'P' && y1 != y2 && reference.at(x2, y2) == '.';
+        totals.promotions += type == 'P' && (x2 == 0 || x2 == 7);
+        totals.plies++;
+        
+        board.movePiece(x1, y1, x2, y2);
+        reference.makeMove(move);
+        played.push_back(move);
+    }
+}
+
+} // namespace
+
+#ifdef CHESS_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t next = 1;
+    auto choose = [&](const ReferenceBoard&, const std::vector<FuzzMove>& legal) {
+        return next < size ? static_cast<int>(data[next++] % legal.size()) : -1;
+    };
+    FuzzTotals totals;
+    if (!playGame(START_POSITIONS[data[0] % NUM_START_POSITIONS], DEFAULT_MAX_PLIES, choose, totals)) {
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+int main(int argc, char* argv[]) {
+    int games = DEFAULT_GAMES;
+    int maxPlies = DEFAULT_MAX_PLIES;
+    uint64_t seed = std::random_device()();
+    std::string fen;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) {
+            games = std::atoi(argv[++i]);
+        } else if (arg == "--plies" && hasValue) {
+            maxPlies = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg.compare(0, 2, "--") != 0) {
+            fen += (fen.empty() ? "" : " ") + arg;
+        } else {
+            std::cerr << "Usage: fuzz [--games N] [--plies N] [--seed N] [fen]\n";
+            return 1;
+        }
+    }
+    
+    // Half of the moves are drawn from the special moves when there are any
+    std::mt19937_64 random(seed);
+    auto choose = [&](const ReferenceBoard& reference, const std::vector<FuzzMove>& legal) {
+        std::vector<int> special;
+        for (size_t i = 0; i < legal.size(); ++i) {
+            if (isSpecialMove(reference, legal[i])) special.push_back(static_cast<int>(i));
+        }
+        if (!special.empty() && random() % 2 == 0) {
+            return special[random() % special.size()];
+        }
+        return static_cast<int>(random() % legal.size());
+    };
+    
+    std::cout << "Seed: " << seed << "\n";
+    auto start = std::chrono::steady_clock::now();
+    FuzzTotals totals;
+    for (int game = 0; game < games; ++game) {
+        const std::string& startFEN = fen.empty() ? START_POSITIONS[game % NUM_START_POSITIONS] : fen;
+        if (!playGame(startFEN, maxPlies, choose, totals)) {
+            std::cout << "Failed in game " << game + 1 << " (seed " << seed << ")\n";
+            return 1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::cout << "Games: " << totals.games << ", plies: " << totals.plies << ", castles: " << totals.castles
+              << ", en passant: " << totals.enPassants << ", promotions: " << totals.promotions
+              << ", checkmates: " << totals.checkmates << ", stalemates: " << totals.stalemates << "\n"
+              << "No differences (" << seconds << " s)\n";
+    return 0;
+}
+
+#endif
@@ -0,0 +1,678 @@
+// Plays two UCI engines (two builds, or one build with different arguments) against each other.
+// Each of the N concurrent slots runs its own pair of engine processes. Every opening is played
+// twice with colours reversed. Clocks use a base time plus an increment per move, and an engine
+// that overruns its clock, crashes or plays an illegal move loses the game. Games are adjudicated
+// as won when both engines agree on a large score, and drawn when the score stays near zero.
+// Results are reported as Elo with a 95% error bar. With --sprt the match stops as soon as the
+// sequential probability ratio test accepts either hypothesis.
+// Usage: match --engine1 CMD --engine2 CMD [--name1 S] [--name2 S] [--games N] [--concurrency N]
+//              [--openings file.epd|file.pgn] [--tc seconds+increment] [--pgn out.pgn]
+//              [--sprt elo0 elo1] [--alpha A] [--beta B]
+//              [--resign cp moves] [--draw movenumber cp moves] [--maxmoves N]
+
+#include "../include/EPD.h"
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include "../include/PGN.h"
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::pair<std::pair<int, int>, std::pair<int, int>> MatchMove;
+
+const char* const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+const int STARTUP_TIMEOUT_MS = 10000;
+// Allowance over the clock before a move counts as a time forfeit, for process latency
+const int TIME_MARGIN_MS = 50;
+// Stands in for a mate score when comparing engine scores against the adjudication thresholds
+const int MATE_CP = 100000;
+
+struct Options {
+    std::string commands[2];
+    std::string names[2];
+    int games = 100;
+    int concurrency = 1;
+    std::string openings;
+    int baseMs = 10000;
+    int incrementMs = 100;
+    std::string timeControl = "10+0.1";
+    std::string pgn;
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+    int resignCp = 0, resignMoves = 0; // Disabled unless both are set
+    int drawMoveNumber = 0, drawCp = 0, drawMoves = 0;
+    int maxMoves = 200; // Full moves before the game is adjudicated a draw
+};
+
+struct Opening {
+    std::string fen;
+    std::vector<MatchMove> moves;
+};
+
+struct GameRecord {
+    int round;
+    bool engine1White;
+    std::string fen;
+    std::vector<std::string> sanMoves;
+    std::string result; // "1-0", "0-1" or "1/2-1/2"
+    std::string termination;
+};
+
+// Shared between the match slots; guarded by mutex
+struct MatchState {
+    std::mutex mutex;
+    int nextGame = 0;
+    int finished = 0;
+    int wins = 0, draws = 0, losses = 0; // From engine 1's point of view
+    bool stop = false;
+    std::ofstream pgn;
+};
+
+// A UCI engine running as a child process, spoken to through a pair of pipes
+class EngineProcess {
+public:
+    ~EngineProcess() { stop(); }
+    
+    bool start(const std::string& command) {
+        int toChild[2], fromChild[2];
+        if (pipe(toChild) != 0) {
+            return false;
+        }
+        if (pipe(fromChild) != 0) {
+            close(toChild[0]);
+            close(toChild[1]);
+            return false;
+        }
+        pid = fork();
+        if (pid == 0) {
+            dup2(toChild[0], STDIN_FILENO);
+            dup2(fromChild[1], STDOUT_FILENO);
+            close(toChild[0]);
+            close(toChild[1]);
+            close(fromChild[0]);
+            close(fromChild[1]);
+            execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(toChild[0]);
+        close(fromChild[1]);
+        input = toChild[1];
+        output = fromChild[0];
+        buffer.clear();
+        if (pid < 0) {
+            stop();
+            return false;
+        }
+        
+        std::string line;
+        send("uci");
+        while (readLine(line, STARTUP_TIMEOUT_MS)) {
+            if (line == "uciok") {
+                return isReady();
+            }
+        }
+        stop();
+        return false;
+    }
+    
+    bool isRunning() const { return pid > 0; }
+    
+    bool isReady() {
+        send("isready");
+        std::string line;
+        while (readLine(line, STARTUP_TIMEOUT_MS)) {
+            if (line == "readyok") {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void send(const std::string& line) {
+        std::string text = line + "\n";
+        if (input >= 0 && write(input, text.data(), text.size()) != static_cast<ssize_t>(text.size())) {
+            stop(); // The engine has gone away
+        }
+    }
+    
+    // Returns false on timeout or when the engine exits
+    bool readLine(std::string& line, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (output >= 0) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd descriptor = {output, POLLIN, 0};
+            if (left.count() <= 0 || poll(&descriptor, 1, static_cast<int>(left.count())) <= 0) {
+                return false;
+            }
+            char chunk[4096];
+            ssize_t count = read(output, chunk, sizeof(chunk));
+            if (count <= 0) {
+                stop();
+                return false;
+            }
+            buffer.append(chunk, count);
+        }
+        return false;
+    }
+    
+    void stop() {
+        if (pid > 0) {
+            if (input >= 0) {
+                std::string quit = "quit\n";
+                ssize_t ignored = write(input, quit.data(), quit.size());
+                (void)ignored;
+            }
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        if (input >= 0) close(input);
+        if (output >= 0) close(output);
+        pid = -1;
+        input = output = -1;
+    }
+
+private:
+    pid_t pid = -1;
+    int input = -1;  // Engine's stdin
+    int output = -1; // Engine's stdout
+    std::string buffer;
+};
+
+bool parseTimeControl(const std::string& text, Options& options) {
+    size_t plus = text.find('+');
+    double base = std::atof(text.substr(0, plus).c_str());
+    double increment = plus == std::string::npos ? 0 : std::atof(text.substr(plus + 1).c_str());
+    options.baseMs = static_cast<int>(base * 1000);
+    options.incrementMs = static_cast<int>(increment * 1000);
+    options.timeControl = text;
+    return options.baseMs > 0 && options.incrementMs >= 0;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto has = [&](int values) { return i + values < argc; };
+        if (arg == "--engine1" && has(1)) {
+            options.commands[0] = argv[++i];
+        } else if (arg == "--engine2" && has(1)) {
+            options.commands[1] = argv[++i];
+        } else if (arg == "--name1" && has(1)) {
+            options.names[0] = argv[++i];
+        } else if (arg == "--name2" && has(1)) {
+            options.names[1] = argv[++i];
+        } else if (arg == "--games" && has(1)) {
+            options.games = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--concurrency" && has(1)) {
+            options.concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--openings" && has(1)) {
+            options.openings = argv[++i];
+        } else if (arg == "--tc" && has(1)) {
+            if (!parseTimeControl(argv[++i], options)) return false;
+        } else if (arg == "--pgn" && has(1)) {
+            options.pgn = argv[++i];
+        } else if (arg == "--sprt" && has(2)) {
+            options.sprt = true;
+            options.elo0 = std::atof(argv[++i]);
+            options.elo1 = std::atof(argv[++i]);
+        } else if (arg == "--alpha" && has(1)) {
+            options.alpha = std::atof(argv[++i]);
+        } else if (arg == "--beta" && has(1)) {
+            options.beta = std::atof(argv[++i]);
+        } else if (arg == "--resign" && has(2)) {
+            options.resignCp = std::atoi(argv[++i]);
+            options.resignMoves = std::atoi(argv[++i]);
+        } else if (arg == "--draw" && has(3)) {
+            options.drawMoveNumber = std::atoi(argv[++i]);
+            options.drawCp = std::atoi(argv[++i]);
+            options.drawMoves = std::atoi(argv[++i]);
+        } else if (arg == "--maxmoves" && has(1)) {
+            options.maxMoves = std::atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    
+    for (int i = 0; i < 2; ++i) {
+        if (options.names[i].empty()) options.names[i] = options.commands[i];
+    }
+    return !options.commands[0].empty() && !options.commands[1].empty();
+}
+
+// EPD/FEN lines, or the games of a PGN file played out to their last move
+bool loadOpenings(const std::string& filename, std::vector<Opening>& openings) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for reading.\n";
+        return false;
+    }
+    
+    bool isPGN = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".pgn") == 0;
+    if (isPGN) {
+        PGNGame pgn;
+        while (readPGNGame(file, pgn)) {
+            Opening opening;
+            opening.fen = pgn.tag("FEN").empty() ? START_FEN : pgn.tag("FEN");
+            Game replay;
+            if (!replay.setFEN(opening.fen)) {
+                continue;
+            }
+            for (const auto& token : pgn.moves) {
+                MatchMove move = parseMove(replay.getBoard(), token);
+                if (!replay.applyMove(move.first.first, move.first.second, move.second.first, move.second.second)) {
+                    break;
+                }
+                opening.moves.push_back(move);
+            }
+            openings.push_back(opening);
+        }
+    } else {
+        std::string line;
+        while (std::getline(file, line)) {
+            EPDRecord record;
+            Game check;
+            if (parseEPD(line, record) && check.setFEN(record.toFEN())) {
+                openings.push_back({record.toFEN(), {}});
+            }
+        }
+    }
+    return !openings.empty();
+}
+
+// Expected score for an Elo difference, and its inverse
+double expectedScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double eloFromScore(double score) {
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+struct EloEstimate {
+    double elo;
+    double error; // Half-width of the 95% confidence interval
+};
+
+// Per-game variance of the score, with half a game of each result added so that one-sided
+// results (a clean sweep, say) keep some uncertainty instead of a variance of zero
+double scoreVariance(int wins, int draws, int losses) {
+    double w = wins + 0.5, d = draws + 0.5, l = losses + 0.5;
+    double games = w + d + l;
+    double mean = (w + 0.5 * d) / games;
+    return (w * std::pow(1 - mean, 2) + d * std::pow(0.5 - mean, 2) + l * std::pow(mean, 2)) / games;
+}
+
+EloEstimate estimateElo(int wins, int draws, int losses) {
+    int games = wins + draws + losses;
+    double score = (wins + 0.5 * draws) / games;
+    double margin = 1.96 * std::sqrt(scoreVariance(wins, draws, losses) / games);
+    
+    // Keep the score strictly between 0 and 1 so a clean sweep has a finite estimate
+    auto clamp = [](double value) { return std::max(0.001, std::min(0.999, value)); };
+    EloEstimate estimate;
+    estimate.elo = eloFromScore(clamp(score));
+    estimate.error = (eloFromScore(clamp(score + margin)) - eloFromScore(clamp(score - margin))) / 2;
+    return estimate;
+}
+
+// Log-likelihood ratio of elo1 against elo0, using the normal approximation to the trinomial
+// game outcomes (generalised SPRT)
+double sprtLLR(int wins, int draws, int losses, double elo0, double elo1) {
+    int games = wins + draws + losses;
+    if (games == 0) {
+        return 0;
+    }
+    double score = (wins + 0.5 * draws) / games;
+    double variance = scoreVariance(wins, draws, losses);
+    double s0 = expectedScore(elo0), s1 = expectedScore(elo1);
+    return games * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+}
+
+// Engine score in centipawns from White's point of view, parsed from an info line
+bool parseScore(const std::string& line, bool whiteToMove, int& score) {
+    std::istringstream stream(line);
+    std::string token;
+    while (stream >> token) {
+        if (token != "score") continue;
+        std::string kind;
+        int value;
+        if (!(stream >> kind >> value)) return false;
+        if (kind == "cp") {
+            score = value;
+        } else if (kind == "mate") {
+            score = value > 0 ? MATE_CP : -MATE_CP;
+        } else {
+            return false;
+        }
+        if (!whiteToMove) score = -score;
+        return true;
+    }
+    return false;
+}
+
+// Plies played before the FEN position: 0 for White's first move
+int fenPly(const std::string& fen) {
+    std::istringstream fields(fen);
+    std::string field;
+    int ply = 0;
+    for (int i = 0; i < 6 && fields >> field; ++i) {
+        if (i == 1 && field == "b") ply += 1;
+        if (i == 5) ply += 2 * (std::max(1, std::atoi(field.c_str())) - 1);
+    }
+    return ply;
+}
+
+std::string uciMoveText(const Board& board, const MatchMove& move) {
+    std::string text = moveToNotation(move.first.first, move.first.second, move.second.first, move.second.second);
+    PieceCode piece = board.getPieceCode(move.first.first, move.first.second);
+    if (pieceCodeType(piece) == PAWN && (move.second.first == 0 || move.second.first == 7)) {
+        text += 'q';
+    }
+    return text;
+}
+
+// Plays one game; engines[0] is engine 1. Engines that fail are stopped and restarted later.
+GameRecord playGame(const Options& options, const Opening& opening, int round, bool engine1White,
+                    EngineProcess engines[2]) {
+    GameRecord record;
+    record.round = round;
+    record.engine1White = engine1White;
+    record.fen = opening.fen;
+    
+    Game game;
+    game.setFEN(opening.fen);
+    std::string moveList;
+    for (const auto& move : opening.moves) {
+        record.sanMoves.push_back(moveToSAN(game.getBoard(), move));
+        moveList += " " + uciMoveText(game.getBoard(), move);
+        game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second);
+    }
+    
+    for (int i = 0; i < 2; ++i) {
+        engines[i].send("ucinewgame");
+        engines[i].isReady();
+    }
+    
+    int clock[2] = {options.baseMs, options.baseMs}; // Indexed by White
+    int resignPlies = 0, drawPlies = 0, lastScore = 0;
+    int firstPly = fenPly(opening.fen);
+    
+    auto finish = [&](bool whiteWins, bool draw, const std::string& termination) {
+        record.result = draw ? "1/2-1/2" : (whiteWins ? "1-0" : "0-1");
+        record.termination = termination;
+        return record;
+    };
+    
+    while (true) {
+        bool white = game.isWhiteToMove();
+        const Board& board = game.getBoard();
+        if (board.isCheckmate(white)) {
+            return finish(!white, false, "checkmate");
+        }
+        if (board.isStalemate(white)) {
+            return finish(false, true, "stalemate");
+        }
+        std::string drawReason = game.getDrawReason();
+        if (!drawReason.empty()) {
+            return finish(false, true, drawReason);
+        }
+        int ply = firstPly + static_cast<int>(record.sanMoves.size());
+        if (ply >= 2 * options.maxMoves) {
+            return finish(false, true, "adjudication: move limit");
+        }
+        
+        EngineProcess& engine = engines[white == engine1White ? 0 : 1];
+        int side = white ? 1 : 0;
+        if (!engine.isRunning()) {
+            return finish(!white, false, "engine crashed");
+        }
+        engine.send("position fen " + opening.fen + (moveList.empty() ? "" : " moves" + moveList));
+        engine.send("go wtime " + std::to_string(clock[1]) + " btime " + std::to_string(clock[0]) +
+                    " winc " + std::to_string(options.incrementMs) + " binc " + std::to_string(options.incrementMs));
+        
+        auto start = std::chrono::steady_clock::now();
+        std::string line, bestMove;
+        bool hasScore = false;
+        int score = 0;
+        while (engine.readLine(line, clock[side] + TIME_MARGIN_MS + 1000)) {
+            if (line.compare(0, 9, "bestmove ") == 0) {
+                std::istringstream(line.substr(9)) >> bestMove;
+                break;
+            }
+            if (line.compare(0, 5, "info ") == 0) {
+                hasScore = parseScore(line, white, score) || hasScore;
+            }
+        }
+        int elapsed = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        
+        if (bestMove.empty()) {
+            bool crashed = !engine.isRunning();
+            engine.stop(); // A hung engine is restarted before the next game
+            return finish(!white, false, crashed ? "engine crashed" : "time forfeit");
+        }
+        if (elapsed > clock[side] + TIME_MARGIN_MS) {
+            return finish(!white, false, "time forfeit");
+        }
+        clock[side] += options.incrementMs - elapsed;
+        
+        MatchMove move = parseCoordinateMove(bestMove);
+        std::string san = moveToSAN(board, move);
+        std::string text = uciMoveText(board, move);
+        if (!game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second)) {
+            return finish(!white, false, "illegal move " + bestMove);
+        }
+        record.sanMoves.push_back(san);
+        moveList += " " + text;
+        
+        // Score adjudication needs consecutive agreeing scores from both engines
+        if (hasScore) {
+            bool decisive = options.resignMoves > 0 && std::abs(score) >= options.resignCp &&
+                            (resignPlies == 0 || (score > 0) == (lastScore > 0));
+            resignPlies = decisive ? resignPlies + 1 : 0;
+            if (resignPlies >= 2 * options.resignMoves && options.resignMoves > 0) {
+                return finish(score > 0, false, "adjudication: score");
+            }
+            bool drawish = options.drawMoves > 0 && ply / 2 + 1 >= options.drawMoveNumber &&
+                           std::abs(score) <= options.drawCp;
+            drawPlies = drawish ? drawPlies + 1 : 0;
+            if (drawPlies >= 2 * options.drawMoves && options.drawMoves > 0) {
+                return finish(false, true, "adjudication: draw score");
+            }
+            lastScore = score;
+        } else {
+            resignPlies = drawPlies = 0;
+        }
+    }
+}
+
+void writeGame(std::ostream& out, const Options& options, const GameRecord& record) {
+    char date[16];
+    std::time_t now = std::time(nullptr);
+    std::tm local;
+    localtime_r(&now, &local);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", &local);
+    
+    PGNGame pgn;
+    pgn.tags = {
+        {"Event", "match"},
+        {"Site", "local"},
+        {"Date", date},
+        {"Round", std::to_string(record.round)},
+        {"White", options.names[record.engine1White ? 0 : 1]},
+        {"Black", options.names[record.engine1White ? 1 : 0]},
+        {"Result", record.result},
+        {"TimeControl", options.timeControl},
+        {"Termination", record.termination},
+    };
+    if (record.fen != START_FEN) {
+        pgn.tags.push_back({"SetUp", "1"});
+        pgn.tags.push_back({"FEN", record.fen});
+    }
+    writePGNTags(out, pgn);
+    
+    std::string line;
+    auto emit = [&](const std::string& text) {
+        if (!line.empty() && line.length() + 1 + text.length() > 79) {
+            out << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + text;
+    };
+    int firstPly = fenPly(record.fen);
+    for (size_t i = 0; i < record.sanMoves.size(); ++i) {
+        int ply = firstPly + static_cast<int>(i);
+        if (ply % 2 == 0 || i == 0) {
+            emit(std::to_string(ply / 2 + 1) + (ply % 2 == 0 ? "." : "..."));
+        }
+        emit(record.sanMoves[i]);
+    }
+    emit(record.result);
+    out << line << "\n\n";
+}
+
+void reportProgress(const Options& options, MatchState& state, const GameRecord& record) {
+    const std::string& white = options.names[record.engine1White ? 0 : 1];
+    const std::string& black = options.names[record.engine1White ? 1 : 0];
+    std::cout << "Game " << record.round << ": " << white << " - " << black << " " << record.result
+              << " (" << record.termination << ")\n";
+    
+    EloEstimate estimate = estimateElo(state.wins, state.draws, state.losses);
+    char elo[64];
+    std::snprintf(elo, sizeof(elo), "%.1f +/- %.1f", estimate.elo, estimate.error);
+    std::cout << "Score of " << options.names[0] << " vs " << options.names[1] << ": " << state.wins << " - "
+              << state.losses << " - " << state.draws << "  [" << state.finished << " games]  Elo " << elo;
+    
+    if (options.sprt) {
+        double llr = sprtLLR(state.wins, state.draws, state.losses, options.elo0, options.elo1);
+        double lower = std::log(options.beta / (1 - options.alpha));
+        double upper = std::log((1 - options.beta) / options.alpha);
+        char text[96];
+        std::snprintf(text, sizeof(text), "  LLR %.2f (%.2f, %.2f)", llr, lower, upper);
+        std::cout << text;
+        if (llr >= upper || llr <= lower) {
+            std::cout << "\nSPRT: H" << (llr >= upper ? "1" : "0") << " accepted (elo0 " << options.elo0
+                      << ", elo1 " << options.elo1 << ")";
+            state.stop = true;
+        }
+    }
+    std::cout << std::endl;
+}
+
+// One concurrency slot: a pair of engine processes playing games until the match is over
+void runSlot(const Options& options, const std::vector<Opening>& openings, MatchState& state) {
+    EngineProcess engines[2];
+    while (true) {
+        int index;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.stop || state.nextGame >= options.games) {
+                return;
+            }
+            index = state.nextGame++;
+        }
+        
+        for (int i = 0; i < 2; ++i) {
+            if (!engines[i].isRunning() && !engines[i].start(options.commands[i])) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                std::cerr << "Error: Could not start engine " << options.commands[i] << "\n";
+                state.stop = true;
+                return;
+            }
+        }
+        
+        // Each opening is played by both engines with each colour in consecutive games
+        const Opening& opening = openings[(index / 2) % openings.size()];
+        GameRecord record = playGame(options, opening, index + 1, index % 2 == 0, engines);
+        
+        std::lock_guard<std::mutex> lock(state.mutex);
+        bool engine1Won = (record.result == "1-0") == record.engine1White;
+        if (record.result == "1/2-1/2") {
+            state.draws++;
+        } else if (engine1Won) {
+            state.wins++;
+        } else {
+            state.losses++;
+        }
+        state.finished++;
+        if (state.pgn.is_open()) {
+            writeGame(state.pgn, options, record);
+            state.pgn.flush();
+        }
+        reportProgress(options, state, record);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: match --engine1 CMD --engine2 CMD [--name1 S] [--name2 S] [--games N]\n"
+                  << "             [--concurrency N] [--openings file.epd|file.pgn] [--tc seconds+inc]\n"
+                  << "             [--pgn out.pgn] [--sprt elo0 elo1] [--alpha A] [--beta B]\n"
+                  << "             [--resign cp moves] [--draw movenumber cp moves] [--maxmoves N]\n";
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN); // A crashed engine must not take the runner down
+    
+    std::vector<Opening> openings;
+    if (options.openings.empty()) {
+        openings.push_back({START_FEN, {}});
+    } else if (!loadOpenings(options.openings, openings)) {
+        std::cerr << "Error: No openings in " << options.openings << "\n";
+        return 1;
+    }
+    
+    MatchState state;
+    if (!options.pgn.empty()) {
+        state.pgn.open(options.pgn, std::ios::app);
+        if (!state.pgn.is_open()) {
+            std::cerr << "Error: Could not open file " << options.pgn << " for writing.\n";
+            return 1;
+        }
+    }
+    
+    std::vector<std::thread> slots;
+    for (int i = 0; i < options.concurrency; ++i) {
+        slots.emplace_back(runSlot, std::cref(options), std::cref(openings), std::ref(state));
+    }
+    for (auto& slot : slots) {
+        slot.join();
+    }
+    
+    if (state.finished == 0) {
+        return 1;
+    }
+    EloEstimate estimate = estimateElo(state.wins, state.draws, state.losses);
+    char elo[64];
+    std::snprintf(elo, sizeof(elo), "%.1f +/- %.1f", estimate.elo, estimate.error);
+    std::cout << "\nFinished " << state.finished << " games: " << options.names[0] << " vs " << options.names[1]
+              << ": +" << state.wins << " -" << state.losses << " =" << state.draws << "\n"
+              << "Elo difference: " << elo << " (95%)\n";
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Counts leaf nodes of the legal move tree to validate move generation and measure its speed.
+// Usage: perft <depth> [fen]
+
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static uint64_t perft(const Board& board, bool white, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    
+    uint64_t nodes = 0;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            Piece* piece = board.getPiece(i, j);
+            if (!piece || piece->isWhite() != white) {
+                continue;
+            }
+            for (const auto& move : board.getLegalMoves(i, j)) {
+                if (depth == 1) {
+                    nodes++;
+                    continue;
+                }
+                Board child = board;
+                child.movePiece(i, j, move.first, move.second);
+                nodes += perft(child, !white, depth - 1);
+            }
+        }
+    }
+    return nodes;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: perft <depth> [fen]\n";
+        return 1;
+    }
+    
+    int depth = std::atoi(argv[1]);
+    Game game;
+    if (argc > 2) {
+        std::string fen;
+        for (int i = 2; i < argc; ++i) {
+            fen += (i > 2 ? " " : "") + std::string(argv[i]);
+        }
+        if (!game.setFEN(fen)) {
+            std::cout << "Invalid FEN: " << fen << "\n";
+            return 1;
+        }
+    }
+    
+    const Board& board = game.getBoard();
+    bool white = game.isWhiteToMove();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t total = 0;
+    
+    // Divide: node count below each root move
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            Piece* piece = board.getPiece(i, j);
+            if (!piece || piece->isWhite() != white) {
+                continue;
+            }
+            for (const auto& move : board.getLegalMoves(i, j)) {
+                Board child = board;
+                child.movePiece(i, j, move.first, move.second);
+                uint64_t nodes = depth > 1 ? perft(child, !white, depth - 1) : 1;
+                std::cout << moveToNotation(i, j, move.first, move.second) << ": " << nodes << "\n";
+                total += nodes;
+            }
+        }
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nNodes: " << total << "\n";
+    std::cout << "Time: " << static_cast<int>(seconds * 1000) << " ms\n";
+    std::cout << "NPS: " << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0) << "\n";
+    return 0;
+}
@@ -0,0 +1,227 @@
+// Self-play training data generator. Worker threads play the engine against itself at a fixed
+// node budget per move, from openings of random legal moves. Each recorded position gets the
+// search score and, once the game is over, its result; records are PackedPosition (32 bytes,
+// see TrainingData.h) appended to the output file.
+// Only quiet positions are recorded: not in check, a non-capturing best move and no mate score,
+// as an evaluation is tuned against positions it can judge statically.
+// Usage: selfplay [--threads N] [--positions N] [--nodes N] [--random-plies N] [--seed N]
+//                 [--sync seconds] <output.bin>
+
+#include "../include/Evaluation.h"
+#include "../include/Game.h"
+#include "../include/TrainingData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t DEFAULT_POSITIONS = 100000;
+const uint64_t DEFAULT_NODES = 5000;
+const int DEFAULT_RANDOM_PLIES = 8;
+const double DEFAULT_SYNC_SECONDS = 10;
+const int MAX_OPENING_SCORE = 200; // Centipawns; more unbalanced random openings are replayed
+const int MAX_GAME_PLIES = 400;    // Adjudicated as a draw
+const int RESIGN_SCORE = 1000;     // Centipawns, for both searches of RESIGN_PLIES in a row
+const int RESIGN_PLIES = 6;
+const double REPORT_SECONDS = 5;
+
+struct Options {
+    int threads;
+    uint64_t positions;
+    uint64_t nodes;
+    int randomPlies;
+    uint64_t seed;
+    double syncSeconds;
+    std::string output;
+};
+
+struct Totals {
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> positions{0};
+    std::atomic<bool> failed{false};
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.positions = DEFAULT_POSITIONS;
+    options.nodes = DEFAULT_NODES;
+    options.randomPlies = DEFAULT_RANDOM_PLIES;
+    options.seed = std::random_device()();
+    options.syncSeconds = DEFAULT_SYNC_SECONDS;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--positions" && hasValue) {
+            options.positions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--nodes" && hasValue) {
+            options.nodes = std::max(1ULL, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--random-plies" && hasValue) {
+            options.randomPlies = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--sync" && hasValue) {
+            options.syncSeconds = std::atof(argv[++i]);
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else if (options.output.empty()) {
+            options.output = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.output.empty();
+}
+
+bool isGameOver(const Game& game) {
+    const Board& board = game.getBoard();
+    return !board.hasLegalMoves(game.isWhiteToMove()) || !game.getDrawReason().empty();
+}
+
+// Plays random legal moves from the start position until the opening is playable and balanced
+Game randomOpening(const Options& options, std::mt19937_64& random) {
+    SearchLimits limits(0, options.nodes);
+    while (true) {
+        Game game;
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> moves;
+        for (int ply = 0; ply < options.randomPlies && !isGameOver(game); ++ply) {
+            moves.clear();
+            game.getBoard().generateLegalMoves(game.isWhiteToMove(), moves);
+            const auto& move = moves[random() % moves.size()];
+            game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second);
+        }
+        if (!isGameOver(game) && std::abs(game.search(limits).score) <= MAX_OPENING_SCORE) {
+            return game;
+        }
+    }
+}
+
+// Plays one game; returns the recorded positions labelled with the result
+std::vector<PackedPosition> playGame(const Options& options, std::mt19937_64& random) {
+    Game game = randomOpening(options, random);
+    SearchLimits limits(0, options.nodes);
+    std::vector<PackedPosition> positions;
+    int ply = options.randomPlies;
+    int result = 0;
+    int winningSide = 0;  // 1 White, -1 Black: the side the last search scored beyond RESIGN_SCORE
+    int winningPlies = 0; // Consecutive searches that did
+    
+    while (true) {
+        const Board& board = game.getBoard();
+        bool white = game.isWhiteToMove();
+        if (!board.hasLegalMoves(white)) {
+            result = board.isCheck(white) ? (white ? -1 : 1) : 0;
+            break;
+        }
+        if (!game.getDrawReason().empty() || ply >= MAX_GAME_PLIES) {
+            break;
+        }
+        
+        SearchResult search = game.search(limits);
+        const auto& move = search.bestMove;
+        if (search.mateIn != 0) {
+            result = search.mateIn > 0 ? 1 : -1; // A forced mate ends the game early
+            break;
+        }
+        int winner = search.score >= RESIGN_SCORE ? 1 : search.score <= -RESIGN_SCORE ? -1 : 0;
+        winningPlies = winner == 0 ? 0 : winner == winningSide ? winningPlies + 1 : 1;
+        winningSide = winner;
+        if (winningPlies >= RESIGN_PLIES) {
+            result = winner;
+            break;
+        }
+        
+        bool capture = board.getPieceCode(move.second.first, move.second.second) != NO_PIECE ||
+                       board.getEnPassantTarget() == move.second;
+        PackedPosition packed;
+        if (!board.isCheck(white) && !capture && packPosition(board, search.score, 0, ply, packed)) {
+            positions.push_back(packed);
+        }
+        game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second);
+        ply++;
+    }
+    
+    for (auto& packed : positions) {
+        packed.result = static_cast<int8_t>(result);
+    }
+    return positions;
+}
+
+void worker(const Options& options, uint64_t seed, TrainingDataWriter& writer, Totals& totals) {
+    std::mt19937_64 random(seed);
+    while (totals.positions < options.positions && !totals.failed) {
+        std::vector<PackedPosition> positions = playGame(options, random);
+        if (!writer.write(positions)) {
+            totals.failed = true;
+        }
+        totals.games++;
+        totals.positions += positions.size();
+    }
+}
+
+void report(const Totals& totals, double seconds, int threads) {
+    double perSecond = seconds > 0 ? totals.positions / seconds : 0;
+    char line[160];
+    std::snprintf(line, sizeof(line), "Games: %llu  Positions: %llu  Positions/sec: %.0f  per core: %.0f  (%.0f s)\n",
+                  static_cast<unsigned long long>(totals.games.load()),
+                  static_cast<unsigned long long>(totals.positions.load()), perSecond, perSecond / threads, seconds);
+    std::cerr << line;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: selfplay [--threads N] [--positions N] [--nodes N] [--random-plies N] [--seed N]\n"
+                  << "                [--sync seconds] <output.bin>\n";
+        return 1;
+    }
+    if (!loadStartupEvalParams()) {
+        return 1;
+    }
+    
+    TrainingDataWriter writer;
+    if (!writer.open(options.output, options.syncSeconds)) {
+        return 1;
+    }
+    
+    Totals totals;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.threads; ++i) {
+        workers.emplace_back(worker, std::cref(options), options.seed + i, std::ref(writer), std::ref(totals));
+    }
+    
+    // Progress until the workers have the requested positions, then a final report
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    double nextReport = REPORT_SECONDS;
+    while (totals.positions < options.positions && !totals.failed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (elapsed() >= nextReport) {
+            report(totals, elapsed(), options.threads);
+            nextReport += REPORT_SECONDS;
+        }
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    bool ok = writer.close() && !totals.failed;
+    report(totals, elapsed(), options.threads);
+    if (!ok) {
+        std::cerr << "Error: Could not write " << options.output << ".\n";
+        return 1;
+    }
+    std::cout << "Wrote " << writer.getRecordsWritten() << " positions to " << options.output << "\n";
+    return 0;
+}
@@ -0,0 +1,721 @@
+// Headless game server: hosts many games at once for clients speaking line-delimited JSON over a
+// local TCP port or a Unix socket. All connections are multiplexed on one epoll loop, which owns
+// every game; only the quiet Game interface is used (no console I/O). AI moves are searched by a
+// bounded pool of engine threads on a copy of the game, so a slow search never blocks the loop.
+// When the queue of pending searches is full, new requests are refused with "busy" rather than
+// queued without bound.
+//
+// Requests are one JSON object per line; "id" is echoed back in the reply:
+//   {"id":1,"cmd":"new"}                          -> {"id":1,"ok":true,"game":7,"fen":"..."}
+//   {"id":2,"cmd":"new","fen":"<FEN>"}
+//   {"id":3,"cmd":"move","game":7,"move":"e4"}    SAN or coordinate notation
+//   {"id":4,"cmd":"go","game":7,"movetime":500}   also "depth", "nodes"; "play":true plays the move
+//       -> {"id":4,"ok":true,"game":7,"move":"e7e5","san":"e5","score":0,"depth":5,"nodes":...}
+//       score is in centipawns from White's point of view
+//   {"id":5,"cmd":"fen","game":7}
+//   {"id":6,"cmd":"close","game":7}
+// Errors are {"id":...,"ok":false,"error":"..."}. A game is closed with its connection.
+// The open file limit is raised to the hard limit at startup. When the process still runs out of
+// descriptors, the listener leaves the epoll set until a connection closes (or a second passes),
+// so pending clients wait in the backlog instead of waking the loop on every turn.
+// With --cache, search results persist in an analysis cache file (see AnalysisCache.h), so a
+// repeated "go" with a depth or node limit the cache covers is answered at once.
+// The workers share one transposition table of --hash megabytes (see TranspositionTable.h).
+// Usage: server [--port N | --unix path] [--workers N] [--queue N] [--max-movetime ms]
+//               [--cache file [--cache-mb N]] [--hash N]
+
+#include "../include/AnalysisCache.h"
+#include "../include/Evaluation.h"
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include "../include/TranspositionTable.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_PORT = 7878;
+const int DEFAULT_MOVETIME_MS = 1000;
+const size_t MAX_LINE = 64 * 1024; // Longer request lines close the connection
+const uint64_t LISTENER_ID = 0;
+const uint64_t WAKEUP_ID = 1;
+// Retry interval for accepting while out of descriptors with no connection of ours to close
+const int ACCEPT_RETRY_MS = 1000;
+
+struct Options {
+    int port = DEFAULT_PORT;
+    std::string unixPath;
+    int workers = 1;
+    size_t queue = 64;
+    int maxMovetimeMs = 10000;
+    std::string cacheFile;
+    size_t cacheMB = 256;
+    size_t hashMB = 64;
+};
+
+// A flat JSON object: values are kept as raw text, strings unescaped
+typedef std::map<std::string, std::string> JsonObject;
+
+bool parseJsonString(const std::string& text, size_t& pos, std::string& value) {
+    if (pos >= text.size() || text[pos] != '"') return false;
+    value.clear();
+    for (++pos; pos < text.size(); ++pos) {
+        char c = text[pos];
+        if (c == '"') {
+            ++pos;
+            return true;
+        }
+        if (c == '\\' && pos + 1 < text.size()) {
+            char escaped = text[++pos];
+            value += escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+        } else {
+            value += c;
+        }
+    }
+    return false;
+}
+
+// Parses {"key": value, ...} with string, number and literal values (no nesting)
+bool parseJsonObject(const std::string& text, JsonObject& object) {
+    size_t pos = 0;
+    auto skipSpace = [&] {
+        while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+    };
+    skipSpace();
+    if (pos >= text.size() || text[pos++] != '{') return false;
+    skipSpace();
+    if (pos < text.size() && text[pos] == '}') return true;
+    while (true) {
+        std::string key, value;
+        skipSpace();
+        if (!parseJsonString(text, pos, key)) return false;
+        skipSpace();
+        if (pos >= text.size() || text[pos++] != ':') return false;
+        skipSpace();
+        if (pos < text.size() && text[pos] == '"') {
+            if (!parseJsonString(text, pos, value)) return false;
+        } else {
+            size_t start = pos;
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '}' &&
+                   !isspace(static_cast<unsigned char>(text[pos]))) {
+                ++pos;
+            }
+            value = text.substr(start, pos - start);
+            if (value.empty() || value[0] == '{' || value[0] == '[') return false;
+        }
+        object[key] = value;
+        skipSpace();
+        if (pos >= text.size()) return false;
+        if (text[pos] == '}') return true;
+        if (text[pos++] != ',') return false;
+    }
+}
+
+std::string jsonQuote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// The request id is echoed as the client sent it: a number, or a string re-quoted
+std::string echoId(const JsonObject& request) {
+    auto it = request.find("id");
+    if (it == request.end()) return "null";
+    bool numeric = !it->second.empty() &&
+                   std::all_of(it->second.begin(), it->second.end(), [](char c) { return isdigit(c) || c == '-'; });
+    return numeric ? it->second : jsonQuote(it->second);
+}
+
+std::string errorReply(const std::string& id, const std::string& message) {
+    return "{\"id\":" + id + ",\"ok\":false,\"error\":" + jsonQuote(message) + "}\n";
+}
+
+struct SearchJob {
+    uint64_t connection;
+    std::string id;
+    uint64_t game;
+    uint64_t version; // Game version when queued; a changed game is not played on
+    bool play;
+    Game position;
+    SearchLimits limits;
+};
+
+struct SearchDone {
+    SearchJob job;
+    SearchResult result;
+    std::string move; // Coordinate notation, empty if there is no legal move
+    std::string san;
+};
+
+// Bounded queue of searches for the worker threads, plus the finished searches for the loop.
+// The loop is woken through an eventfd whenever a search finishes.
+class EnginePool {
+public:
+    EnginePool(int workers, size_t capacity, int wakeup) : capacity(capacity), wakeup(wakeup) {
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back(&EnginePool::work, this);
+        }
+    }
+    
+    ~EnginePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    
+    // False when the queue is full
+    bool submit(SearchJob job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.size() >= capacity) {
+            return false;
+        }
+        pending.push_back(std::move(job));
+        jobAvailable.notify_one();
+        return true;
+    }
+    
+    std::vector<SearchDone> takeFinished() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<SearchDone> done;
+        done.swap(finished);
+        return done;
+    }
+
+private:
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            jobAvailable.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+            SearchDone done;
+            done.job = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            
+            done.result = done.job.position.search(done.job.limits);
+            const auto& move = done.result.bestMove;
+            if (move.first.first != -1) {
+                done.move = moveToNotation(move.first.first, move.first.second, move.second.first, move.second.second);
+                done.san = moveToSAN(done.job.position.getBoard(), move);
+            }
+            
+            lock.lock();
+            finished.push_back(std::move(done));
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeup, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+    
+    size_t capacity;
+    int wakeup;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<SearchJob> pending;
+    std::vector<SearchDone> finished;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+};
+
+struct Connection {
+    int fd;
+    std::string input;
+    std::string output;
+    std::set<uint64_t> games;
+    bool writable = false; // EPOLLOUT registered
+};
+
+struct HostedGame {
+    Game game;
+    uint64_t connection;
+    uint64_t version = 0; // Bumped on every move
+};
+
+class Server {
+public:
+    Server(const Options& options, AnalysisCache* cache, TranspositionTable* tt, int listener, int epoll, int wakeup)
+        : options(options), cache(cache), tt(tt), listener(listener), epoll(epoll), wakeup(wakeup),
+          pool(options.workers, options.queue, wakeup) {}
+    
+    void run() {
+        std::vector<epoll_event> events(256);
+        while (true) {
+            int timeout = listenerPaused ? ACCEPT_RETRY_MS : -1;
+            int count = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), timeout);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "Error: epoll_wait failed: " << std::strerror(errno) << "\n";
+                return;
+            }
+            if (count == 0) {
+                resumeListener();
+            }
+            for (int i = 0; i < count; ++i) {
+                uint64_t id = events[i].data.u64;
+                if (id == LISTENER_ID) {
+                    acceptConnections();
+                } else if (id == WAKEUP_ID) {
+                    deliverResults();
+                } else {
+                    handleConnection(id, events[i].events);
+                }
+            }
+        }
+    }
+
+private:
+    void acceptConnections() {
+        while (true) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    acceptWarned = false;
+                    return; // The backlog is drained
+                }
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    pauseListener();
+                    return;
+                }
+                if (errno == EBADF || errno == EINVAL || errno == ENOTSOCK) {
+                    std::cerr << "Error: accept failed: " << std::strerror(errno) << "\n";
+                    return;
+                }
+                continue; // That connection failed (aborted by the client); try the next one
+            }
+            uint64_t id = nextConnection++;
+            connections[id].fd = fd;
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.u64 = id;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+    
+    void handleConnection(uint64_t id, uint32_t events) {
+        auto it = connections.find(id);
+        if (it == connections.end()) {
+            return;
+        }
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            closeConnection(id);
+            return;
+        }
+        bool closed = false;
+        if (events & (EPOLLIN | EPOLLRDHUP)) {
+            char chunk[16384];
+            while (true) {
+                ssize_t count = read(it->second.fd, chunk, sizeof(chunk));
+                if (count > 0) {
+                    it->second.input.append(chunk, count);
+                } else {
+                    closed = count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                    break;
+                }
+            }
+            // Requests already received are answered even if the client has stopped sending
+            std::string input;
+            input.swap(it->second.input);
+            size_t start = 0, newline;
+            while ((newline = input.find('\n', start)) != std::string::npos) {
+                handleRequest(id, input.substr(start, newline - start));
+                start = newline + 1;
+                if (!connections.count(id)) {
+                    return; // Closed by a failed write
+                }
+            }
+            it->second.input = input.substr(start);
+            if (it->second.input.size() > MAX_LINE) {
+                closed = true;
+            }
+        }
+        flush(id);
+        if (closed) {
+            closeConnection(id);
+        }
+    }
+    
+    void handleRequest(uint64_t connectionId, const std::string& line) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            return;
+        }
+        JsonObject request;
+        if (!parseJsonObject(line, request)) {
+            reply(connectionId, errorReply("null", "invalid JSON"));
+            return;
+        }
+        std::string id = echoId(request);
+        std::string command = request["cmd"];
+        
+        if (command == "new") {
+            HostedGame hosted;
+            hosted.connection = connectionId;
+            if (request.count("fen") && !hosted.game.setFEN(request["fen"])) {
+                reply(connectionId, errorReply(id, "invalid FEN"));
+                return;
+            }
+            uint64_t gameId = nextGame++;
+            std::string fen = hosted.game.getFEN();
+            games[gameId] = std::move(hosted);
+            connections[connectionId].games.insert(gameId);
+            reply(connectionId, "{\"id\":" + id + ",\"ok\":true,\"game\":" + std::to_string(gameId) +
+                                ",\"fen\":" + jsonQuote(fen) + "}\n");
+            return;
+        }
+        
+        // Every other command names one of this connection's games
+        uint64_t gameId = std::strtoull(request["game"].c_str(), nullptr, 10);
+        auto it = games.find(gameId);
+        if (it == games.end() || it->second.connection != connectionId) {
+            reply(connectionId, errorReply(id, "unknown game"));
+            return;
+        }
+        HostedGame& hosted = it->second;
+        
+        if (command == "move") {
+            auto move = parseMove(hosted.game.getBoard(), request["move"]);
+            std::string san = move.first.first == -1 ? "" : moveToSAN(hosted.game.getBoard(), move);
+            if (!hosted.game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second)) {
+                reply(connectionId, errorReply(id, "illegal move"));
+                return;
+            }
+            hosted.version++;
+            reply(connectionId, "{\"id\":" + id + ",\"ok\":true,\"game\":" + std::to_string(gameId) +
+                                ",\"san\":" + jsonQuote(san) + statusFields(hosted.game) + "}\n");
+        } else if (command == "fen") {
+            reply(connectionId, "{\"id\":" + id + ",\"ok\":true,\"game\":" + std::to_string(gameId) +
+                                statusFields(hosted.game) + "}\n");
+        } else if (command == "go") {
+            SearchJob job;
+            job.connection = connectionId;
+            job.id = id;
+            job.game = gameId;
+            job.version = hosted.version;
+            job.play = request["play"] == "true";
+            job.position = hosted.game;
+            job.limits.depth = std::atoi(request["depth"].c_str());
+            job.limits.nodes = std::strtoull(request["nodes"].c_str(), nullptr, 10);
+            job.limits.movetimeMs = std::atoi(request["movetime"].c_str());
+            // Every search gets a time budget, capped so one request cannot hold a worker forever
+            if (job.limits.movetimeMs <= 0) {
+                job.limits.movetimeMs = std::min(DEFAULT_MOVETIME_MS, options.maxMovetimeMs);
+            }
+            job.limits.movetimeMs = std::min(job.limits.movetimeMs, options.maxMovetimeMs);
+            job.limits.cache = cache;
+            job.limits.tt = tt;
+            if (!pool.submit(std::move(job))) {
+                reply(connectionId, errorReply(id, "busy"));
+            }
+        } else if (command == "close") {
+            games.erase(it);
+            connections[connectionId].games.erase(gameId);
+            reply(connectionId, "{\"id\":" + id + ",\"ok\":true}\n");
+        } else {
+            reply(connectionId, errorReply(id, "unknown command"));
+        }
+    }
+    
+    // FEN, side to move and game state, as ",\"fen\":...,\"status\":..." fields
+    static std::string statusFields(const Game& game) {
+        const Board& board = game.getBoard();
+        bool white = game.isWhiteToMove();
+        std::string status = "playing";
+        if (board.isCheckmate(white)) {
+            status = "checkmate";
+        } else if (board.isStalemate(white)) {
+            status = "stalemate";
+        } else if (!game.getDrawReason().empty()) {
+            status = "draw: " + game.getDrawReason();
+        }
+        return ",\"fen\":" + jsonQuote(game.getFEN()) + ",\"status\":" + jsonQuote(status);
+    }
+    
+    void deliverResults() {
+        uint64_t count;
+        ssize_t ignored = read(wakeup, &count, sizeof(count));
+        (void)ignored;
+        
+        for (auto& done : pool.takeFinished()) {
+            const SearchJob& job = done.job;
+            if (!connections.count(job.connection)) {
+                continue; // The client has gone
+            }
+            std::string text = "{\"id\":" + job.id + ",\"ok\":true,\"game\":" + std::to_string(job.game) +
+                               ",\"move\":" + (done.move.empty() ? "null" : jsonQuote(done.move)) +
+                               ",\"san\":" + (done.san.empty() ? "null" : jsonQuote(done.san)) +
+                               ",\"score\":" + std::to_string(done.result.score) +
+                               ",\"mate\":" + std::to_string(done.result.mateIn) +
+                               ",\"depth\":" + std::to_string(done.result.depth) +
+                               ",\"nodes\":" + std::to_string(done.result.nodes);
+            
+            auto it = games.find(job.game);
+            if (job.play && !done.move.empty()) {
+                if (it == games.end() || it->second.version != job.version) {
+                    reply(job.connection, errorReply(job.id, "game changed during the search"));
+                    continue;
+                }
+                const auto& move = done.result.bestMove;
+                it->second.game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second);
+                it->second.version++;
+                text += ",\"played\":true" + statusFields(it->second.game);
+            }
+            reply(job.connection, text + "}\n");
+        }
+    }
+    
+    void reply(uint64_t connectionId, const std::string& text) {
+        auto it = connections.find(connectionId);
+        if (it != connections.end()) {
+            it->second.output += text;
+            flush(connectionId);
+        }
+    }
+    
+    // Writes what the socket accepts and waits for EPOLLOUT for the rest
+    void flush(uint64_t id) {
+        auto it = connections.find(id);
+        if (it == connections.end()) {
+            return;
+        }
+        Connection& connection = it->second;
+        while (!connection.output.empty()) {
+            ssize_t count = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+            if (count < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    closeConnection(id);
+                    return;
+                }
+                break;
+            }
+            connection.output.erase(0, count);
+        }
+        bool wantWrite = !connection.output.empty();
+        if (wantWrite != connection.writable) {
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            event.data.u64 = id;
+            epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.writable = wantWrite;
+        }
+    }
+    
+    void closeConnection(uint64_t id) {
+        auto it = connections.find(id);
+        if (it == connections.end()) {
+            return;
+        }
+        for (uint64_t game : it->second.games) {
+            games.erase(game);
+        }
+        epoll_ctl(epoll, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        close(it->second.fd);
+        connections.erase(it);
+        resumeListener();
+    }
+    
+    // Out of descriptors (or socket memory): stop polling the listener, which would otherwise
+    // report the same pending connection on every epoll_wait
+    void pauseListener() {
+        if (listenerPaused) {
+            return;
+        }
+        if (!acceptWarned) {
+            std::cerr << "Warning: accept failed with " << connections.size() << " connections open ("
+                      << std::strerror(errno) << "); not accepting until a connection closes\n";
+            acceptWarned = true; // Once until the backlog drains
+        }
+        epoll_ctl(epoll, EPOLL_CTL_DEL, listener, nullptr);
+        listenerPaused = true;
+    }
+    
+    void resumeListener() {
+        if (!listenerPaused) {
+            return;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = LISTENER_ID;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+        listenerPaused = false;
+    }
+    
+    const Options& options;
+    AnalysisCache* cache; // Null without --cache
+    TranspositionTable* tt;
+    int listener;
+    int epoll;
+    int wakeup;
+    EnginePool pool;
+    std::map<uint64_t, Connection> connections;
+    std::map<uint64_t, HostedGame> games;
+    uint64_t nextConnection = 2; // After the listener and wakeup ids
+    uint64_t nextGame = 1;
+    bool listenerPaused = false;
+    bool acceptWarned = false;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    options.workers = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--unix" && hasValue) {
+            options.unixPath = argv[++i];
+        } else if (arg == "--workers" && hasValue) {
+            options.workers = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--queue" && hasValue) {
+            options.queue = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-movetime" && hasValue) {
+            options.maxMovetimeMs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--cache" && hasValue) {
+            options.cacheFile = argv[++i];
+        } else if (arg == "--cache-mb" && hasValue) {
+            options.cacheMB = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--hash" && hasValue) {
+            options.hashMB = std::max(1, std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Listens on 127.0.0.1:port, or on a Unix socket when a path is given; -1 on error
+int openListener(const Options& options) {
+    int fd;
+    if (!options.unixPath.empty()) {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (fd < 0 || options.unixPath.size() >= sizeof(address.sun_path)) return -1;
+        std::strcpy(address.sun_path, options.unixPath.c_str());
+        unlink(options.unixPath.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return -1;
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return -1;
+    }
+    return listen(fd, SOMAXCONN) == 0 ? fd : -1;
+}
+
+// Every connection holds a descriptor, so take the hard open file limit rather than the soft one
+// (often 1024). Returns the limit in effect.
+rlim_t raiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        std::cerr << "Warning: Could not read the open file limit: " << std::strerror(errno) << "\n";
+        return 0;
+    }
+    // An unlimited hard limit still cannot exceed fs.nr_open, whose default is 2^20
+    rlim_t wanted = limit.rlim_max == RLIM_INFINITY ? 1 << 20 : limit.rlim_max;
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < wanted) {
+        rlimit raised = limit;
+        raised.rlim_cur = wanted;
+        if (setrlimit(RLIMIT_NOFILE, &raised) != 0) {
+            std::cerr << "Warning: Could not raise the open file limit from " << limit.rlim_cur << " to "
+                      << wanted << ": " << std::strerror(errno) << "\n";
+            return limit.rlim_cur;
+        }
+        return wanted;
+    }
+    return limit.rlim_cur;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: server [--port N | --unix path] [--workers N] [--queue N] [--max-movetime ms]\n"
+                  << "              [--cache file [--cache-mb N]] [--hash N]\n";
+        return 1;
+    }
+    if (!loadStartupEvalParams()) {
+        return 1;
+    }
+    AnalysisCache cache;
+    if (!options.cacheFile.empty() && !cache.open(options.cacheFile, analysisCacheEntries(options.cacheMB))) {
+        return 1;
+    }
+    // Cleared by one thread per worker, so the pages spread over the NUMA nodes they run on
+    TranspositionTable tt;
+    if (!tt.resize(options.hashMB, options.workers)) {
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    rlim_t fileLimit = raiseFileLimit();
+    
+    int listener = openListener(options);
+    if (listener < 0) {
+        std::cerr << "Error: Could not listen: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    int wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll < 0 || wakeup < 0) {
+        std::cerr << "Error: Could not create epoll or eventfd: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER_ID;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+    event.data.u64 = WAKEUP_ID;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+    
+    std::cerr << "Listening on " << (options.unixPath.empty() ? "127.0.0.1:" + std::to_string(options.port)
+                                                              : options.unixPath)
+              << " with " << options.workers << " engine workers, " << tt.sizeMB() << " MB hash ("
+              << tt.pageModeName() << " pages), open file limit " << fileLimit << "\n";
+    Server server(options, cache.isOpen() ? &cache : nullptr, &tt, listener, epoll, wakeup);
+    server.run();
+    return 1;
+}
@@ -0,0 +1,224 @@
+// Protocol check for the game server: starts a server on a private Unix socket with one engine
+// worker and a queue of one, then plays a scripted session as a client and checks every reply.
+// Covers new, move, go (with and without "play"), fen and close, an illegal move, an unknown game,
+// a line that is not JSON, the "busy" reply once the worker and the queue are taken, and a
+// "play":true search whose game was moved on while it was queued.
+// Usage: server_client [--server path]      (default ./server)
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace {
+
+const int CONNECT_TIMEOUT_MS = 5000;
+const int REPLY_TIMEOUT_MS = 15000;
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Raw text of a top-level field: strings without their quotes, anything else as written
+std::string field(const std::string& reply, const std::string& name) {
+    std::string key = "\"" + name + "\":";
+    size_t start = reply.find(key);
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += key.size();
+    if (start < reply.size() && reply[start] == '"') {
+        size_t end = reply.find('"', start + 1);
+        return reply.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+    }
+    size_t end = reply.find_first_of(",}", start);
+    return reply.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+class Client {
+public:
+    bool connectTo(const std::string& path) {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return true;
+        }
+        if (fd >= 0) close(fd);
+        fd = -1;
+        return false;
+    }
+    
+    ~Client() {
+        if (fd >= 0) close(fd);
+    }
+    
+    bool send(const std::string& line) {
+        std::string text = line + "\n";
+        return write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+    }
+    
+    // The reply with this id (as its JSON text); replies to other requests are kept for later
+    std::string await(const std::string& id) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REPLY_TIMEOUT_MS);
+        while (!replies.count(id)) {
+            size_t newline = input.find('\n');
+            if (newline != std::string::npos) {
+                std::string line = input.substr(0, newline);
+                input.erase(0, newline + 1);
+                replies[field(line, "id")] = line;
+                continue;
+            }
+            int left = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count());
+            pollfd readable = {fd, POLLIN, 0};
+            if (left <= 0 || poll(&readable, 1, left) <= 0) {
+                return "(no reply)";
+            }
+            char buffer[4096];
+            ssize_t count = read(fd, buffer, sizeof(buffer));
+            if (count <= 0) {
+                return "(connection closed)";
+            }
+            input.append(buffer, count);
+        }
+        std::string reply = replies[id];
+        replies.erase(id);
+        return reply;
+    }
+    
+    std::string request(const std::string& id, const std::string& line) {
+        return send(line) ? await(id) : "(send failed)";
+    }
+
+private:
+    int fd = -1;
+    std::string input;
+    std::map<std::string, std::string> replies;
+};
+
+int failures = 0;
+
+void check(bool passed, const std::string& name, const std::string& reply) {
+    if (passed) {
+        std::cout << "ok    " << name << "\n";
+    } else {
+        std::cout << "FAIL  " << name << ": " << reply << "\n";
+        failures++;
+    }
+}
+
+void runSession(Client& client) {
+    std::string reply = client.request("1", "{\"id\":1,\"cmd\":\"new\"}");
+    std::string game = field(reply, "game");
+    check(field(reply, "ok") == "true" && !game.empty() && field(reply, "fen") == START_FEN, "new", reply);
+    
+    reply = client.request("2", "{\"id\":2,\"cmd\":\"move\",\"game\":" + game + ",\"move\":\"e4\"}");
+    check(field(reply, "ok") == "true" && field(reply, "san") == "e4", "move", reply);
+    
+    reply = client.request("3", "{\"id\":3,\"cmd\":\"move\",\"game\":" + game + ",\"move\":\"e2e4\"}");
+    check(field(reply, "error") == "illegal move", "illegal move", reply);
+    
+    reply = client.request("4", "{\"id\":4,\"cmd\":\"fen\",\"game\":" + game + "}");
+    check(field(reply, "fen") == "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1" &&
+          field(reply, "status") == "playing", "fen", reply);
+    
+    reply = client.request("5", "{\"id\":5,\"cmd\":\"go\",\"game\":" + game + ",\"depth\":3}");
+    check(field(reply, "ok") == "true" && field(reply, "move").size() >= 4 && field(reply, "depth") == "3" &&
+          field(reply, "played").empty(), "go", reply);
+    
+    reply = client.request("6", "{\"id\":6,\"cmd\":\"go\",\"game\":" + game + ",\"depth\":2,\"play\":true}");
+    check(field(reply, "played") == "true" && field(reply, "fen").find(" w ") != std::string::npos,
+          "go play", reply);
+    
+    reply = client.request("null", "{\"id\":7,\"cmd\":");
+    check(field(reply, "error") == "invalid JSON", "invalid JSON", reply);
+    
+    reply = client.request("8", "{\"id\":8,\"cmd\":\"fen\",\"game\":999999}");
+    check(field(reply, "error") == "unknown game", "unknown game", reply);
+    
+    // The worker takes the first search, the second waits in the queue of one, the third is refused
+    client.send("{\"id\":10,\"cmd\":\"go\",\"game\":" + game + ",\"movetime\":1000}");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    client.send("{\"id\":11,\"cmd\":\"go\",\"game\":" + game + ",\"movetime\":500,\"play\":true}");
+    reply = client.request("12", "{\"id\":12,\"cmd\":\"go\",\"game\":" + game + ",\"movetime\":500}");
+    check(field(reply, "error") == "busy", "busy", reply);
+    
+    // A move made while search 11 is queued: its result must not be played on the changed game
+    reply = client.request("13", "{\"id\":13,\"cmd\":\"move\",\"game\":" + game + ",\"move\":\"Nf3\"}");
+    check(field(reply, "ok") == "true", "move while searching", reply);
+    reply = client.await("10");
+    check(field(reply, "ok") == "true" && field(reply, "move").size() >= 4, "queued go", reply);
+    reply = client.await("11");
+    check(field(reply, "error") == "game changed during the search", "go play on a changed game", reply);
+    std::string fen = field(client.request("14", "{\"id\":14,\"cmd\":\"fen\",\"game\":" + game + "}"), "fen");
+    check(fen.find(" b ") != std::string::npos && fen.find("5N2") != std::string::npos,
+          "game unchanged by the stale search", fen);
+    
+    reply = client.request("15", "{\"id\":15,\"cmd\":\"close\",\"game\":" + game + "}");
+    check(field(reply, "ok") == "true", "close", reply);
+    reply = client.request("16", "{\"id\":16,\"cmd\":\"fen\",\"game\":" + game + "}");
+    check(field(reply, "error") == "unknown game", "closed game is gone", reply);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string serverPath = "./server";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--server" && i + 1 < argc) {
+            serverPath = argv[++i];
+        } else {
+            std::cerr << "Usage: server_client [--server path]\n";
+            return 1;
+        }
+    }
+    
+    std::string socketPath = "/tmp/server_client_" + std::to_string(getpid()) + ".sock";
+    pid_t server = fork();
+    if (server == 0) {
+        execl(serverPath.c_str(), serverPath.c_str(), "--unix", socketPath.c_str(), "--workers", "1",
+              "--queue", "1", static_cast<char*>(nullptr));
+        std::cerr << "Error: Could not start " << serverPath << ": " << std::strerror(errno) << "\n";
+        _exit(127);
+    }
+    if (server < 0) {
+        std::cerr << "Error: fork failed: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    
+    // The server is ready once its socket accepts a connection
+    Client client;
+    bool connected = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+    while (!connected && std::chrono::steady_clock::now() < deadline) {
+        if (waitpid(server, nullptr, WNOHANG) == server) {
+            std::cerr << "Error: The server exited at startup.\n";
+            return 1;
+        }
+        connected = client.connectTo(socketPath);
+        if (!connected) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    if (connected) {
+        runSession(client);
+    } else {
+        std::cerr << "Error: Could not connect to the server on " << socketPath << ".\n";
+        failures++;
+    }
+    
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+    unlink(socketPath.c_str());
+    std::cout << (failures == 0 ? "All checks passed\n" : std::to_string(failures) + " checks failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Runs an EPD test suite (WAC, STS, ECM, ...) through Game::search, the search behind
+// getMinimaxMove. A position is solved when the final best move is one of its "bm" moves, or
+// none of its "am" moves. Its time to solution is when the search settled on a solving move:
+// the end of the first iteration after which every later iteration kept a solving move.
+// Positions run one at a time so the timings and nodes per second are not shared with others.
+// Usage: suite [--movetime ms] [--nodes N] [--depth N] <suite.epd>
+
+#include "../include/EPD.h"
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_MOVETIME_MS = 1000;
+
+typedef std::pair<std::pair<int, int>, std::pair<int, int>> SuiteMove;
+
+struct Options {
+    SearchLimits limits;
+    std::string input;
+};
+
+// Upper bounds, in seconds, of the time-to-solution histogram buckets
+const double TTS_BUCKETS[] = {0.01, 0.1, 1.0, 10.0};
+const int NUM_TTS_BUCKETS = sizeof(TTS_BUCKETS) / sizeof(TTS_BUCKETS[0]);
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--movetime" && hasValue) {
+            options.limits.movetimeMs = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            options.limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--depth" && hasValue) {
+            options.limits.depth = std::atoi(argv[++i]);
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else if (options.input.empty()) {
+            options.input = arg;
+        } else {
+            return false;
+        }
+    }
+    
+    if (!options.limits.depth && !options.limits.nodes && !options.limits.movetimeMs) {
+        options.limits.movetimeMs = DEFAULT_MOVETIME_MS;
+    }
+    return !options.input.empty();
+}
+
+// Parses a space-separated list of SAN moves; returns false if any of them is not legal
+bool parseMoveList(const Board& board, const std::string& operand, std::vector<SuiteMove>& moves) {
+    std::istringstream stream(operand);
+    std::string san;
+    while (stream >> san) {
+        SuiteMove move = parseMove(board, san);
+        if (move.first.first == -1) {
+            return false;
+        }
+        moves.push_back(move);
+    }
+    return true;
+}
+
+bool isSolution(const SuiteMove& move, const std::vector<SuiteMove>& best, const std::vector<SuiteMove>& avoid) {
+    if (!best.empty() && std::find(best.begin(), best.end(), move) == best.end()) {
+        return false;
+    }
+    return std::find(avoid.begin(), avoid.end(), move) == avoid.end();
+}
+
+std::string formatSeconds(double seconds) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", seconds);
+    return buffer;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: suite [--movetime ms] [--nodes N] [--depth N] <suite.epd>\n";
+        return 1;
+    }
+    
+    std::ifstream input(options.input);
+    if (!input.is_open()) {
+        std::cerr << "Error: Could not open file " << options.input << " for reading.\n";
+        return 1;
+    }
+    
+    int positions = 0, solved = 0, skipped = 0;
+    SearchStats totals; // Merged over all positions
+    std::vector<double> solveTimes;
+    
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        EPDRecord record;
+        if (!parseEPD(line, record)) {
+            continue;
+        }
+        std::string id = unquote(record.operation("id"));
+        if (id.empty()) {
+            id = "line " + std::to_string(lineNumber);
+        }
+        
+        Game game;
+        std::vector<SuiteMove> best, avoid;
+        if (!game.setFEN(record.toFEN()) ||
+            !parseMoveList(game.getBoard(), record.operation("bm"), best) ||
+            !parseMoveList(game.getBoard(), record.operation("am"), avoid) ||
+            (best.empty() && avoid.empty())) {
+            std::cerr << id << ": invalid position or missing bm/am, skipped\n";
+            skipped++;
+            continue;
+        }
+        
+        // Time of the completed iteration from which the best move has solved the position
+        double solvedSince = -1;
+        SearchResult result = game.search(options.limits, [&](const SearchResult& iteration) {
+            if (!isSolution(iteration.bestMove, best, avoid)) {
+                solvedSince = -1;
+            } else if (solvedSince < 0) {
+                solvedSince = iteration.seconds;
+            }
+        });
+        
+        bool found = isSolution(result.bestMove, best, avoid);
+        positions++;
+        totals.merge(result.stats);
+        
+        std::string expected = !best.empty() ? "bm " + record.operation("bm") : "am " + record.operation("am");
+        const SuiteMove& move = result.bestMove;
+        std::cout << id << ": " << (found ? "solved" : "failed") << "  " << expected << "  played "
+                  << moveToSAN(game.getBoard(), move) << "  depth " << result.depth << "  nodes " << result.nodes;
+        if (found) {
+            // A solution found by an interrupted first iteration counts from the end of the search
+            double tts = solvedSince >= 0 ? solvedSince : result.seconds;
+            solveTimes.push_back(tts);
+            solved++;
+            std::cout << "  time " << formatSeconds(tts) << " s";
+        }
+        std::cout << "\n";
+    }
+    
+    std::cout << "\nSolved: " << solved << " / " << positions;
+    if (positions > 0) {
+        std::cout << " (" << (100 * solved / positions) << "%)";
+    }
+    std::cout << "\n";
+    if (skipped > 0) {
+        std::cout << "Skipped: " << skipped << "\n";
+    }
+    
+    if (!solveTimes.empty()) {
+        std::sort(solveTimes.begin(), solveTimes.end());
+        double sum = 0;
+        for (double seconds : solveTimes) {
+            sum += seconds;
+        }
+        std::cout << "Time to solution: mean " << formatSeconds(sum / solveTimes.size())
+                  << " s, median " << formatSeconds(solveTimes[solveTimes.size() / 2])
+                  << " s, max " << formatSeconds(solveTimes.back()) << " s\n";
+        
+        // Cumulative: positions solved within each bound
+        for (int i = 0; i < NUM_TTS_BUCKETS; ++i) {
+            auto count = std::upper_bound(solveTimes.begin(), solveTimes.end(), TTS_BUCKETS[i]) - solveTimes.begin();
+            std::cout << "  <= " << TTS_BUCKETS[i] << " s: " << count << "\n";
+        }
+    }
+    
+    std::cout << "Nodes: " << totals.nodes << "\n"
+              << "Time: " << static_cast<int>(totals.seconds * 1000) << " ms\n"
+              << "Nodes/sec: " << static_cast<uint64_t>(totals.nodesPerSecond()) << "\n"
+              << "Stats: " << totals.toJSON() << "\n";
+    return 0;
+}
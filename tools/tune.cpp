@@ -0,0 +1,322 @@
+// Texel-style evaluation tuner. Fits the piece values and piece-square tables of EvalParams to
+// labelled positions (PackedPosition files from tools/selfplay.cpp) by minimising
+//   E = mean((R - sigmoid(eval))^2),  sigmoid(x) = 1 / (1 + 10^(-K x / 400))
+// where R is the game result (1, 0.5, 0 for White) mixed with the sigmoid of the recorded search
+// score by --lambda. K is first fitted to the starting parameters unless --k is given.
+// The evaluation is linear in its parameters, so records are evaluated straight from the
+// memory-mapped file as sums of weights, and the gradient is those weights' feature counts times
+// the error term. Each epoch is one full pass: threads split the records, their gradients are
+// summed, and Adam takes one step. The result is written as a parameter file (see Evaluation.h).
+// Usage: tune [--threads N] [--epochs N] [--rate cp] [--lambda X] [--k X] [--init params]
+//             <positions.bin> <output.params>
+
+#include "../include/Evaluation.h"
+#include "../include/MappedFile.h"
+#include "../include/TrainingData.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int DEFAULT_EPOCHS = 100;
+const double DEFAULT_RATE = 1;     // Adam step size in centipawns
+const double ADAM_BETA1 = 0.9;
+const double ADAM_BETA2 = 0.999;
+const double ADAM_EPSILON = 1e-8;
+const double MIN_K = 0.01;
+const double MAX_K = 10;
+const int K_ITERATIONS = 40;
+
+// Weights: the piece values, then the piece-square tables, in EvalParams order
+const int WEIGHT_COUNT = PIECE_TYPE_COUNT + PIECE_TYPE_COUNT * 64;
+const int MAX_FEATURES = 64;       // Two per piece
+
+inline int valueWeight(int type) { return type; }
+inline int squareWeight(int type, int square) { return PIECE_TYPE_COUNT + type * 64 + square; }
+
+struct Options {
+    int threads;
+    int epochs;
+    double rate;
+    double lambda;
+    double k; // 0 to fit
+    std::string init;
+    std::string input;
+    std::string output;
+};
+
+struct Dataset {
+    const PackedPosition* records;
+    size_t count;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.epochs = DEFAULT_EPOCHS;
+    options.rate = DEFAULT_RATE;
+    options.lambda = 0;
+    options.k = 0;
+    
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--epochs" && hasValue) {
+            options.epochs = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--rate" && hasValue) {
+            options.rate = std::atof(argv[++i]);
+        } else if (arg == "--lambda" && hasValue) {
+            options.lambda = std::max(0.0, std::min(1.0, std::atof(argv[++i])));
+        } else if (arg == "--k" && hasValue) {
+            options.k = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--init" && hasValue) {
+            options.init = argv[++i];
+        } else if (arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != 2) {
+        return false;
+    }
+    options.input = files[0];
+    options.output = files[1];
+    return true;
+}
+
+// The evaluation's terms for a record: weight indices and their signs (+1 White, -1 Black).
+// Returns the number of terms; pieces with an invalid code are skipped.
+int decodeFeatures(const PackedPosition& packed, int* weights, int* signs) {
+    int count = 0;
+    Bitboard occupied = packed.occupancy;
+    for (int i = 0; occupied && i < 32; ++i) {
+        int square = popLowestSquare(occupied);
+        PieceCode code = static_cast<PieceCode>(packed.pieces[i / 2] >> (i % 2 * 4) & 15);
+        int color = pieceCodeColor(code);
+        int type = pieceCodeType(code);
+        if (type < 0 || type >= PIECE_TYPE_COUNT) {
+            continue;
+        }
+        int sign = color == WHITE ? 1 : -1;
+        weights[count] = valueWeight(type);
+        signs[count++] = sign;
+        weights[count] = squareWeight(type, relativeSquare(color, square));
+        signs[count++] = sign;
+    }
+    return count;
+}
+
+// scale is K ln(10) / 400, so the sigmoid is 1 / (1 + e^(-scale x))
+inline double sigmoid(double x, double scale) {
+    return 1 / (1 + std::exp(-scale * x));
+}
+
+// Squared error summed over records [begin, end); adds the gradient of that sum if gradient is set
+double errorSum(const Dataset& data, size_t begin, size_t end, const std::vector<double>& weights,
+                double scale, double lambda, double* gradient) {
+    int features[MAX_FEATURES];
+    int signs[MAX_FEATURES];
+    double total = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const PackedPosition& packed = data.records[i];
+        int count = decodeFeatures(packed, features, signs);
+        double eval = 0;
+        for (int f = 0; f < count; ++f) {
+            eval += signs[f] * weights[features[f]];
+        }
+        
+        double predicted = sigmoid(eval, scale);
+        double target = (1 - lambda) * (packed.result + 1) / 2.0 + lambda * sigmoid(packed.score, scale);
+        double difference = target - predicted;
+        total += difference * difference;
+        if (gradient) {
+            double term = -2 * difference * predicted * (1 - predicted) * scale;
+            for (int f = 0; f < count; ++f) {
+                gradient[features[f]] += signs[f] * term;
+            }
+        }
+    }
+    return total;
+}
+
+// Mean squared error over all records, split across threads. Sets gradient to the gradient of
+// the mean when it is not null.
+double meanError(const Dataset& data, const std::vector<double>& weights, double k, double lambda,
+                 int threads, std::vector<double>* gradient) {
+    double scale = k * std::log(10.0) / 400;
+    std::vector<double> errors(threads);
+    std::vector<std::vector<double>> gradients(threads, std::vector<double>(gradient ? WEIGHT_COUNT : 0));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        size_t begin = data.count * t / threads;
+        size_t end = data.count * (t + 1) / threads;
+        workers.emplace_back([&, t, begin, end] {
+            errors[t] = errorSum(data, begin, end, weights, scale, lambda, gradient ? gradients[t].data() : nullptr);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    double total = 0;
+    for (int t = 0; t < threads; ++t) {
+        total += errors[t];
+    }
+    if (gradient) {
+        gradient->assign(WEIGHT_COUNT, 0);
+        for (int t = 0; t < threads; ++t) {
+            for (int w = 0; w < WEIGHT_COUNT; ++w) {
+                (*gradient)[w] += gradients[t][w] / data.count;
+            }
+        }
+    }
+    return total / data.count;
+}
+
+// Golden-section search for the K that minimises the error of the starting parameters
+double fitK(const Dataset& data, const std::vector<double>& weights, double lambda, int threads) {
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = MIN_K;
+    double high = MAX_K;
+    double a = high - ratio * (high - low);
+    double b = low + ratio * (high - low);
+    double errorA = meanError(data, weights, a, lambda, threads, nullptr);
+    double errorB = meanError(data, weights, b, lambda, threads, nullptr);
+    for (int i = 0; i < K_ITERATIONS; ++i) {
+        if (errorA < errorB) {
+            high = b;
+            b = a;
+            errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = meanError(data, weights, a, lambda, threads, nullptr);
+        } else {
+            low = a;
+            a = b;
+            errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = meanError(data, weights, b, lambda, threads, nullptr);
+        }
+    }
+    return (low + high) / 2;
+}
+
+std::vector<double> paramsToWeights(const EvalParams& params) {
+    std::vector<double> weights(WEIGHT_COUNT);
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        weights[valueWeight(t)] = params.pieceValues[t];
+        for (int square = 0; square < 64; ++square) {
+            weights[squareWeight(t, square)] = params.pieceSquare[t][square];
+        }
+    }
+    return weights;
+}
+
+// Rounds the weights into parameters. A constant added to one piece type's table and taken off
+// its value leaves the evaluation unchanged, so each table is centred on the squares the data
+// covers, keeping the material values readable. The kings cancel out, so their value is kept.
+EvalParams weightsToParams(const std::vector<double>& weights, const Bitboard* covered, const EvalParams& initial) {
+    EvalParams params = initial;
+    for (int t = 0; t < PIECE_TYPE_COUNT; ++t) {
+        double mean = 0;
+        int squares = popCount(covered[t]);
+        for (Bitboard b = covered[t]; b; ) {
+            mean += weights[squareWeight(t, popLowestSquare(b))] / squares;
+        }
+        if (t != KING) {
+            params.pieceValues[t] = static_cast<int>(std::lround(weights[valueWeight(t)] + mean));
+        }
+        for (int square = 0; square < 64; ++square) {
+            double weight = weights[squareWeight(t, square)];
+            params.pieceSquare[t][square] = static_cast<int>(std::lround(covered[t] & squareBit(square) ? weight - mean : weight));
+        }
+    }
+    return params;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: tune [--threads N] [--epochs N] [--rate cp] [--lambda X] [--k X] [--init params]\n"
+                  << "            <positions.bin> <output.params>\n";
+        return 1;
+    }
+    
+    EvalParams initial;
+    if (!options.init.empty() && !loadEvalParams(options.init, initial)) {
+        return 1;
+    }
+    MappedFile file;
+    if (!file.open(options.input, false)) {
+        return 1;
+    }
+    if (file.size() % sizeof(PackedPosition) != 0) {
+        std::cerr << "Error: " << options.input << " is not a file of packed positions.\n";
+        return 1;
+    }
+    Dataset data = { reinterpret_cast<const PackedPosition*>(file.data()), file.size() / sizeof(PackedPosition) };
+    
+    // Squares each piece type occurs on, from its owner's side; only these weights are trained
+    Bitboard covered[PIECE_TYPE_COUNT] = {};
+    int features[MAX_FEATURES];
+    int signs[MAX_FEATURES];
+    for (size_t i = 0; i < data.count; ++i) {
+        int count = decodeFeatures(data.records[i], features, signs);
+        for (int f = 1; f < count; f += 2) {
+            int type = (features[f] - PIECE_TYPE_COUNT) / 64;
+            covered[type] |= squareBit((features[f] - PIECE_TYPE_COUNT) % 64);
+        }
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    std::vector<double> weights = paramsToWeights(initial);
+    double k = options.k > 0 ? options.k : fitK(data, weights, options.lambda, options.threads);
+    std::printf("Positions: %zu  Threads: %d  K: %.4f%s\n", data.count, options.threads, k,
+                options.k > 0 ? "" : " (fitted)");
+    
+    // Adam over every weight but the king's value
+    std::vector<double> gradient;
+    std::vector<double> moment(WEIGHT_COUNT, 0);
+    std::vector<double> velocity(WEIGHT_COUNT, 0);
+    double initialError = 0;
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        double epochStart = elapsed();
+        double error = meanError(data, weights, k, options.lambda, options.threads, &gradient);
+        if (epoch == 1) initialError = error;
+        
+        double correction1 = 1 - std::pow(ADAM_BETA1, epoch);
+        double correction2 = 1 - std::pow(ADAM_BETA2, epoch);
+        for (int w = 0; w < WEIGHT_COUNT; ++w) {
+            if (w == valueWeight(KING)) continue;
+            moment[w] = ADAM_BETA1 * moment[w] + (1 - ADAM_BETA1) * gradient[w];
+            velocity[w] = ADAM_BETA2 * velocity[w] + (1 - ADAM_BETA2) * gradient[w] * gradient[w];
+            weights[w] -= options.rate * (moment[w] / correction1) / (std::sqrt(velocity[w] / correction2) + ADAM_EPSILON);
+        }
+        std::printf("Epoch %d  error %.6f  (%.2f s)\n", epoch, error, elapsed() - epochStart);
+        std::fflush(stdout);
+    }
+    
+    EvalParams tuned = weightsToParams(weights, covered, initial);
+    double finalError = meanError(data, paramsToWeights(tuned), k, options.lambda, options.threads, nullptr);
+    if (options.epochs == 0) initialError = finalError;
+    std::printf("Error: %.6f -> %.6f  (%.1f s)\n", initialError, finalError, elapsed());
+    std::printf("Values: P %d  N %d  B %d  R %d  Q %d\n", tuned.pieceValues[PAWN], tuned.pieceValues[KNIGHT],
+                tuned.pieceValues[BISHOP], tuned.pieceValues[ROOK], tuned.pieceValues[QUEEN]);
+    if (!saveEvalParams(options.output, tuned)) {
+        return 1;
+    }
+    std::cout << "Wrote " << options.output << "\n";
+    return 0;
+}
@@ -0,0 +1,313 @@
+// Minimal UCI front end so the engine can be driven by chess GUIs and match runners.
+// Supported: uci, isready, ucinewgame, position [startpos | fen <fen>] [moves ...],
+// go [depth N] [nodes N] [movetime ms] [wtime ms btime ms [winc ms binc ms] [movestogo N]] [infinite],
+// stop, setoption name MultiPV value N, setoption name EvalFile value <file>,
+// setoption name AnalysisCache value <file> (and AnalysisCacheMB), setoption name Hash value <MB>,
+// quit. Searches run in the background so "stop" and "isready"
+// are answered while searching; after every completed depth an info line with the principal
+// variation is printed for each of the MultiPV best moves. The non-standard "stats" command prints
+// the statistics of the last search as one JSON line; "trace on <file>" and "trace off" record a
+// Chrome trace of the searches in between (builds configured with CHESS_TRACE only); either one
+// stops a search in progress. "go infinite" prints its bestmove only after "stop" (or "quit").
+
+#include "../include/AnalysisCache.h"
+#include "../include/Engine.h"
+#include "../include/Evaluation.h"
+#include "../include/Game.h"
+#include "../include/Notation.h"
+#include "../include/Trace.h"
+#include "../include/TranspositionTable.h"
+#include <algorithm>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static const int DEFAULT_DEPTH = 3;
+// Moves assumed left in the game when the time control does not say
+static const int DEFAULT_MOVES_TO_GO = 30;
+// Kept on the clock for process and pipe latency
+static const int MOVE_OVERHEAD_MS = 20;
+// Depth cap for "go infinite", which otherwise runs until "stop"
+static const int INFINITE_DEPTH = 64;
+static const int MAX_MULTI_PV = 64;
+static const int DEFAULT_CACHE_MB = 64;
+static const int MAX_CACHE_MB = 65536;
+static const int DEFAULT_HASH_MB = 16;
+static const int MAX_HASH_MB = 65536;
+
+// Serialises output from the command loop and the search thread
+static std::mutex outputMutex;
+
+static void sendLine(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+static void setPosition(Game& game, std::istringstream& iss) {
+    std::string token;
+    iss >> token;
+    
+    if (token == "startpos") {
+        game = Game();
+        iss >> token; // "moves" if present
+    } else if (token == "fen") {
+        std::string fen, field;
+        while (iss >> field && field != "moves") {
+            fen += (fen.empty() ? "" : " ") + field;
+        }
+        if (!game.setFEN(fen)) {
+            sendLine("info string invalid fen " + fen);
+            return;
+        }
+        token = field;
+    }
+    
+    if (token != "moves") {
+        return;
+    }
+    
+    std::string moveStr;
+    while (iss >> moveStr) {
+        auto move = parseCoordinateMove(moveStr);
+        if (!game.applyMove(move.first.first, move.first.second, move.second.first, move.second.second)) {
+            sendLine("info string illegal move " + moveStr);
+            return;
+        }
+    }
+}
+
+// A share of the remaining time plus most of the increment, never the whole clock
+static int allocateTime(int timeLeft, int increment, int movesToGo) {
+    int budget = timeLeft / std::max(1, movesToGo) + increment * 3 / 4;
+    budget = std::min(budget, timeLeft / 2);
+    return std::max(1, std::min(budget, timeLeft - MOVE_OVERHEAD_MS));
+}
+
+static std::string uciMove(const Board& board, const std::pair<std::pair<int, int>, std::pair<int, int>>& move) {
+    std::string text = moveToNotation(move.first.first, move.first.second, move.second.first, move.second.second);
+    PieceCode piece = board.getPieceCode(move.first.first, move.first.second);
+    if (pieceCodeType(piece) == PAWN && (move.second.first == 0 || move.second.first == 7)) {
+        text += 'q'; // Pawns always promote to a queen
+    }
+    return text;
+}
+
+// The moves of a principal variation, each preceded by a space
+static std::string pvText(Board board, const std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>>& pv) {
+    std::string text;
+    for (const auto& move : pv) {
+        text += " " + uciMove(board, move);
+        board.movePiece(move.first.first, move.first.second, move.second.first, move.second.second);
+    }
+    return text;
+}
+
+static SearchHandle go(const Game& game, std::istringstream& iss, int multiPV, AnalysisCache& cache,
+                       TranspositionTable& tt, bool& infinite) {
+    SearchLimits limits;
+    limits.multiPV = multiPV;
+    limits.cache = cache.isOpen() ? &cache : nullptr;
+    limits.tt = tt.empty() ? nullptr : &tt;
+    int timeLeft[2] = {0, 0}, increment[2] = {0, 0}; // Indexed by White
+    int movesToGo = DEFAULT_MOVES_TO_GO;
+    std::string token;
+    while (iss >> token) {
+        if (token == "depth") {
+            iss >> limits.depth;
+        } else if (token == "nodes") {
+            iss >> limits.nodes;
+        } else if (token == "movetime") {
+            iss >> limits.movetimeMs;
+        } else if (token == "wtime") {
+            iss >> timeLeft[1];
+        } else if (token == "btime") {
+            iss >> timeLeft[0];
+        } else if (token == "winc") {
+            iss >> increment[1];
+        } else if (token == "binc") {
+            iss >> increment[0];
+        } else if (token == "movestogo") {
+            iss >> movesToGo;
+        } else if (token == "infinite") {
+            limits.depth = INFINITE_DEPTH;
+            limits.infinite = true;
+        }
+    }
+    
+    infinite = limits.infinite;
+    int side = game.isWhiteToMove() ? 1 : 0;
+    if (!limits.movetimeMs && timeLeft[side] > 0) {
+        limits.movetimeMs = allocateTime(timeLeft[side], increment[side], movesToGo);
+    }
+    if (!limits.depth && !limits.nodes && !limits.movetimeMs) {
+        limits.depth = DEFAULT_DEPTH;
+    }
+    
+    // Scores are reported from the side to move's point of view, in centipawns. The callbacks
+    // run on the search thread and keep their own copy of the board.
+    int sign = game.isWhiteToMove() ? 1 : -1;
+    Board board = game.getBoard();
+    TranspositionTable* table = limits.tt;
+    return Engine::search(game, limits, [sign, board, multiPV, table](const SearchResult& iteration) {
+        int ms = static_cast<int>(iteration.seconds * 1000);
+        for (size_t i = 0; i < iteration.lines.size(); ++i) {
+            const SearchLine& line = iteration.lines[i];
+            std::ostringstream info;
+            info << "info depth " << line.depth;
+            if (multiPV > 1) {
+                info << " multipv " << i + 1;
+            }
+            info << " score ";
+            if (line.mateIn != 0) {
+                info << "mate " << sign * line.mateIn;
+            } else {
+                info << "cp " << sign * line.score;
+            }
+            info << " nodes " << iteration.nodes << " time " << ms
+                 << " nps " << static_cast<uint64_t>(iteration.nodes / std::max(iteration.seconds, 0.001));
+            if (table) {
+                info << " hashfull " << table->hashfull();
+            }
+            info << " pv" << pvText(board, line.pv);
+            sendLine(info.str());
+        }
+    });
+}
+
+// The search in progress and the thread that prints its bestmove when it ends. The bestmove of
+// "go infinite" is held back until stopSearch releases it, even if the search ends by itself.
+struct RunningSearch {
+    SearchHandle handle;
+    std::thread reporter;
+    std::promise<void> released;
+};
+
+static void startSearch(RunningSearch& running, const Game& game, std::istringstream& iss, int multiPV,
+                        AnalysisCache& cache, TranspositionTable& tt, SearchStats& stats) {
+    bool infinite = false;
+    running.handle = go(game, iss, multiPV, cache, tt, infinite);
+    running.released = std::promise<void>();
+    std::shared_future<void> release = running.released.get_future().share();
+    SearchHandle handle = running.handle;
+    Board board = game.getBoard();
+    running.reporter = std::thread([handle, board, infinite, release, &stats] {
+        const SearchResult& result = handle.wait();
+        if (infinite) {
+            release.wait();
+        }
+        std::lock_guard<std::mutex> lock(outputMutex);
+        stats = result.stats;
+        std::cout << "bestmove " << (result.bestMove.first.first == -1 ? "0000" : uciMove(board, result.bestMove))
+                  << std::endl;
+    });
+}
+
+// Stops the search, if any, and returns once its bestmove has been printed
+static void stopSearch(RunningSearch& running) {
+    if (running.reporter.joinable()) {
+        running.handle.stop();
+        running.released.set_value();
+        running.reporter.join();
+    }
+    running.handle = SearchHandle();
+}
+
+int main() {
+    loadStartupEvalParams();
+    Game game;
+    SearchStats lastStats;
+    RunningSearch running;
+    int multiPV = 1;
+    AnalysisCache cache;
+    std::string cacheFile;
+    int cacheMB = DEFAULT_CACHE_MB;
+    TranspositionTable tt;
+    if (!tt.resize(DEFAULT_HASH_MB)) {
+        return 1;
+    }
+    std::string line;
+    
+    while (std::getline(std::cin, line)) {
+        std::istringstream iss(line);
+        std::string command;
+        iss >> command;
+        
+        if (command == "uci") {
+            sendLine("id name ChessGame\nid author ChessGame contributors\n"
+                     "option name MultiPV type spin default 1 min 1 max " + std::to_string(MAX_MULTI_PV) + "\n"
+                     "option name EvalFile type string default <empty>\n"
+                     "option name AnalysisCache type string default <empty>\n"
+                     "option name AnalysisCacheMB type spin default " + std::to_string(DEFAULT_CACHE_MB) +
+                     " min 1 max " + std::to_string(MAX_CACHE_MB) + "\n"
+                     "option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) +
+                     " min 1 max " + std::to_string(MAX_HASH_MB) + "\nuciok");
+        } else if (command == "setoption") {
+            std::string token, name, value;
+            while (iss >> token && token != "value") {
+                if (token != "name") name += (name.empty() ? "" : " ") + token;
+            }
+            std::getline(iss >> std::ws, value);
+            if (name == "MultiPV") {
+                multiPV = std::max(1, std::min(MAX_MULTI_PV, std::atoi(value.c_str())));
+            } else if (name == "EvalFile") {
+                stopSearch(running);
+                EvalParams params;
+                if (loadEvalParams(value, params)) {
+                    setEvalParams(params);
+                } else {
+                    sendLine("info string could not load EvalFile " + value);
+                }
+            } else if (name == "AnalysisCache" || name == "AnalysisCacheMB") {
+                stopSearch(running);
+                if (name == "AnalysisCache") {
+                    cacheFile = value == "<empty>" ? "" : value;
+                } else {
+                    cacheMB = std::max(1, std::min(MAX_CACHE_MB, std::atoi(value.c_str())));
+                }
+                cache.close();
+                if (!cacheFile.empty() && !cache.open(cacheFile, analysisCacheEntries(cacheMB))) {
+                    sendLine("info string could not open AnalysisCache " + cacheFile);
+                }
+            } else if (name == "Hash") {
+                stopSearch(running);
+                int hashMB = std::max(1, std::min(MAX_HASH_MB, std::atoi(value.c_str())));
+                if (!tt.resize(hashMB)) {
+                    sendLine("info string could not allocate Hash " + std::to_string(hashMB) + " MB");
+                    tt.resize(DEFAULT_HASH_MB);
+                }
+                sendLine("info string Hash " + std::to_string(tt.sizeMB()) + " MB, " + tt.pageModeName() + " pages");
+            }
+        } else if (command == "isready") {
+            sendLine("readyok");
+        } else if (command == "ucinewgame") {
+            stopSearch(running);
+            game = Game();
+            tt.clear();
+        } else if (command == "position") {
+            stopSearch(running);
+            setPosition(game, iss);
+        } else if (command == "go") {
+            stopSearch(running);
+            startSearch(running, game, iss, multiPV, cache, tt, lastStats);
+        } else if (command == "stop") {
+            stopSearch(running);
+        } else if (command == "trace") {
+            stopSearch(running); // The trace buffers are only safe to start or write between searches
+            std::string mode, filename;
+            iss >> mode >> filename;
+            bool ok = mode == "on" ? traceStart(filename) : traceStop();
+            sendLine("info string trace " + (ok ? mode : std::string("failed")));
+        } else if (command == "stats") {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "info string stats " << lastStats.toJSON() << std::endl;
+        } else if (command == "quit") {
+            break;
+        }
+    }
+    stopSearch(running);
+    return 0;
+}